@@ -2,9 +2,19 @@
 
 #include "act-iter.h"
 
+#include <algorithm>
+
 #include "env.h"
 #include "losglobal.h"
 
+// The first monster slot after i that may hold a monster, or MAX_MONSTERS.
+static int _next_mons_slot(int i)
+{
+    const vector<int> &used = env.mons_used;
+    auto it = upper_bound(used.begin(), used.end(), i);
+    return it == used.end() ? MAX_MONSTERS : *it;
+}
+
 actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
     : center(c), _los(los), viewer(nullptr), i(-1)
 {
@@ -64,7 +74,7 @@ bool actor_near_iterator::valid(const actor* a) const
 void actor_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = _next_mons_slot(i)) >= MAX_MONSTERS)
              return;
     while (!valid(**this));
 }
@@ -72,18 +82,16 @@ void actor_near_iterator::advance()
 //////////////////////////////////////////////////////////////////////////
 
 monster_near_iterator::monster_near_iterator(coord_def c, los_type los)
-    : center(c), _los(los), viewer(nullptr), i(0)
+    : center(c), _los(los), viewer(nullptr), i(-1)
 {
-    if (!valid(&menv[0]))
-        advance();
+    advance();
     begin_point = i;
 }
 
 monster_near_iterator::monster_near_iterator(const actor *a, los_type los)
-    : center(a->pos()), _los(los), viewer(a), i(0)
+    : center(a->pos()), _los(los), viewer(a), i(-1)
 {
-    if (!valid(&menv[0]))
-        advance();
+    advance();
     begin_point = i;
 }
 
@@ -154,7 +162,7 @@ bool monster_near_iterator::valid(const monster* a) const
 void monster_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = _next_mons_slot(i)) >= MAX_MONSTERS)
              return;
     while (!valid(**this));
 }
@@ -162,10 +170,9 @@ void monster_near_iterator::advance()
 //////////////////////////////////////////////////////////////////////////
 
 monster_iterator::monster_iterator()
-    : i(0)
+    : i(-1)
 {
-    while (i < MAX_MONSTERS && !menv[i].alive())
-        i++;
+    advance();
 }
 
 monster_iterator::operator bool() const
@@ -188,9 +195,7 @@ monster* monster_iterator::operator->() const
 
 monster_iterator& monster_iterator::operator++()
 {
-    while (++i < MAX_MONSTERS)
-        if (menv[i].alive())
-            break;
+    advance();
     return *this;
 }
 
@@ -204,7 +209,7 @@ monster_iterator monster_iterator::operator++(int)
 void monster_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = _next_mons_slot(i)) >= MAX_MONSTERS)
              return;
     while (!(*this)->alive());
 }
@@ -7,9 +7,11 @@
 
 #include "arena.h"
 
+#include <chrono>
 #include <stdexcept>
 
 #include "act-iter.h"
+#include "beam.h"
 #include "colour.h"
 #include "command.h"
 #include "dungeon.h"
@@ -219,6 +221,11 @@ namespace arena
 
     static int turns       = 0;
 
+    // Time spent in world_reacts() over all trials, for benchmarking.
+    static int total_turns = 0;
+    static chrono::duration<double, milli> turn_ms;
+    static tracer_cache_stats tracers;
+
     static bool allow_summons       = true;
     static bool allow_animate       = true;
     static bool allow_chain_summons = true;
@@ -231,6 +238,7 @@ namespace arena
     static bool move_summons        = false;
     static bool respawn             = false;
     static bool move_respawns       = false;
+    static bool report_timing       = false;
 
     static bool miscasts            = false;
 
@@ -444,6 +452,7 @@ namespace arena
         miscasts        =  strip_tag(spec, "miscasts");
         respawn         =  strip_tag(spec, "respawn");
         move_respawns   =  strip_tag(spec, "move_respawns");
+        report_timing   =  strip_tag(spec, "timing");
         summon_throttle = strip_number_tag(spec, "summon_throttle:");
 
         if (real_summons && respawn)
@@ -878,7 +887,12 @@ namespace arena
 
                 you.time_taken = 10;
                 //report_foes();
+                const auto turn_start = chrono::high_resolution_clock::now();
                 world_reacts();
+                turn_ms += chrono::high_resolution_clock::now() - turn_start;
+                total_turns++;
+                tracers.hits += tracer_cache_counts().hits;
+                tracers.misses += tracer_cache_counts().misses;
                 do_miscasts();
                 do_respawn(faction_a);
                 do_respawn(faction_b);
@@ -977,6 +991,9 @@ namespace arena
         // Clear some things that shouldn't persist across restart_after_game.
         // parse_monster_spec and setup_fight will clear the rest.
         total_trials = trials_done = team_a_wins = ties = 0;
+        total_turns = 0;
+        turn_ms = turn_ms.zero();
+        tracers = { 0, 0 };
         contest_cancelled = false;
         is_respawning = false;
         uniques_list.clear();
@@ -1097,6 +1114,14 @@ namespace arena
                  faction_b.desc.c_str(), trials_done - team_a_wins - ties,
                  ties);
             mpr(outcome);
+            if (report_timing && total_turns)
+            {
+                mprf("%d turns, %.3f ms per turn, %.1f/%.1f monster "
+                     "tracers reused/fired per turn", total_turns,
+                     turn_ms.count() / total_turns,
+                     (double) tracers.hits / total_turns,
+                     (double) tracers.misses / total_turns);
+            }
             if (!skipped_arena_ui)
                 _results_popup(outcome);
         }
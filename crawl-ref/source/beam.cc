@@ -2020,6 +2020,64 @@ int silver_damages_victim(actor* victim, int damage, string &dmg_msg)
     return ret;
 }
 
+// What a monster's tracer depends on, other than the level itself, which
+// mustn't change while a tracer_cache_scope is alive.
+struct tracer_key
+{
+    mid_t caster;
+    coord_def source;
+    coord_def target;
+    spell_type spell;
+    beam_type flavour;
+    int range;
+    int ex_size;
+    int foe_ratio;
+    bool is_explosion;
+    bool pierce;
+    bool aimed_at_spot;
+    bool explode_only;
+    bool explosion_hole;
+
+    bool operator==(const tracer_key &other) const
+    {
+        return caster == other.caster && source == other.source
+               && target == other.target && spell == other.spell
+               && flavour == other.flavour && range == other.range
+               && ex_size == other.ex_size && foe_ratio == other.foe_ratio
+               && is_explosion == other.is_explosion
+               && pierce == other.pierce
+               && aimed_at_spot == other.aimed_at_spot
+               && explode_only == other.explode_only
+               && explosion_hole == other.explosion_hole;
+    }
+};
+
+// Only a handful of tracers get fired in one scope, so a list will do.
+static vector<pair<tracer_key, bolt>> tracer_cache;
+static int tracer_cache_depth = 0;
+static tracer_cache_stats tracer_counts = { 0, 0 };
+
+tracer_cache_scope::tracer_cache_scope()
+{
+    tracer_cache_depth++;
+}
+
+tracer_cache_scope::~tracer_cache_scope()
+{
+    if (!--tracer_cache_depth)
+        tracer_cache.clear();
+}
+
+tracer_cache_stats tracer_cache_counts()
+{
+    return tracer_counts;
+}
+
+void reset_tracer_cache_counts()
+{
+    tracer_counts = { 0, 0 };
+}
+
 //  Used by monsters in "planning" which spell to cast. Fires off a "tracer"
 //  which tells the monster what it'll hit if it breathes/casts etc.
 //
@@ -2064,6 +2122,26 @@ void fire_tracer(const monster* mons, bolt &pbolt, bool explode_only,
 
     pbolt.in_explosion_phase = false;
 
+    const tracer_key key = { mons->mid, pbolt.source, pbolt.target,
+                             pbolt.origin_spell, pbolt.flavour,
+                             pbolt.range, pbolt.ex_size, pbolt.foe_ratio,
+                             pbolt.is_explosion, pbolt.pierce,
+                             pbolt.aimed_at_spot, explode_only,
+                             explosion_hole };
+    if (tracer_cache_depth)
+    {
+        for (const auto &entry : tracer_cache)
+        {
+            if (entry.first == key)
+            {
+                tracer_counts.hits++;
+                pbolt = entry.second;
+                return;
+            }
+        }
+        tracer_counts.misses++;
+    }
+
     // Fire!
     if (explode_only)
         pbolt.explode(false, explosion_hole);
@@ -2072,6 +2150,9 @@ void fire_tracer(const monster* mons, bolt &pbolt, bool explode_only,
 
     // Unset tracer flag (convenience).
     pbolt.is_tracer = false;
+
+    if (tracer_cache_depth)
+        tracer_cache.emplace_back(key, pbolt);
 }
 
 vector<coord_def> create_feat_splash(coord_def center,
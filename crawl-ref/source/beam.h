@@ -321,6 +321,29 @@ bool curare_actor(actor* source, actor* target, int levels, string name,
 int silver_damages_victim(actor* victim, int damage, string &dmg_msg);
 void fire_tracer(const monster* mons, bolt &pbolt,
                   bool explode_only = false, bool explosion_hole = false);
+
+/**
+ * While one of these is alive, fire_tracer() remembers the tracers it has
+ * fired and hands back the same results for repeats, rather than tracing
+ * them again. Only use it around code that doesn't change the level, such
+ * as a monster weighing up its spells.
+ */
+class tracer_cache_scope
+{
+public:
+    tracer_cache_scope();
+    ~tracer_cache_scope();
+};
+
+struct tracer_cache_stats
+{
+    int hits;
+    int misses;
+};
+
+// Tracer cache hits and misses since the start of this turn.
+tracer_cache_stats tracer_cache_counts();
+void reset_tracer_cache_counts();
 spret zapping(zap_type ztype, int power, bolt &pbolt,
                    bool needs_tracer = false, const char* msg = nullptr,
                    bool fail = false);
@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include <map>
+
+#include "grid-map.h"
+#include "libutil.h"
+
+// Random changes to a grid_map and a map must leave them the same, and
+// iterating in the same order.
+TEST_CASE("grid_map behaves like a map", "[single-file]")
+{
+    grid_map<int> grid;
+    map<coord_def, int> ref;
+    uint32_t seed = 12345;
+    auto rand = [&seed](int n) {
+        seed = seed * 1103515245 + 12345;
+        return int((seed >> 16) % n);
+    };
+
+    for (int i = 0; i < 20000; i++)
+    {
+        const coord_def c(rand(GXM), rand(GYM / 8));
+        switch (rand(3))
+        {
+        case 0:
+            grid[c] = i;
+            ref[c] = i;
+            break;
+        case 1:
+            REQUIRE(grid.erase(c) == ref.erase(c));
+            break;
+        default:
+        {
+            const int *value = map_find(grid, c);
+            const int *ref_value = map_find(ref, c);
+            REQUIRE(!value == !ref_value);
+            if (value)
+                REQUIRE(*value == *ref_value);
+            break;
+        }
+        }
+    }
+
+    REQUIRE(grid.size() == ref.size());
+    auto ri = ref.begin();
+    for (const auto &entry : grid)
+    {
+        REQUIRE(ri != ref.end());
+        REQUIRE(entry.first == ri->first);
+        REQUIRE(entry.second == ri->second);
+        ++ri;
+    }
+    REQUIRE(ri == ref.end());
+
+    REQUIRE(grid.find(coord_def(-1, 0)) == grid.end());
+    REQUIRE(grid.count(coord_def(GXM, 0)) == 0);
+
+    grid.clear();
+    REQUIRE(grid.empty());
+    REQUIRE(grid.begin() == grid.end());
+}
+
+// An entry keeps its id until erased, even though its pool entry is reused.
+TEST_CASE("grid_map entry ids", "[single-file]")
+{
+    grid_map<int> grid;
+    const coord_def a(3, 4), b(5, 6);
+
+    REQUIRE(grid.entry_id(a) == 0);
+    grid[a] = 1;
+    const uint32_t first = grid.entry_id(a);
+    REQUIRE(first != 0);
+
+    grid[a] = 2;
+    REQUIRE(grid.entry_id(a) == first);
+
+    grid.erase(a);
+    REQUIRE(grid.entry_id(a) == 0);
+    grid[a] = 3;
+    REQUIRE(grid.entry_id(a) != first);
+
+    grid[b] = 4;
+    REQUIRE(grid.entry_id(b) != grid.entry_id(a));
+    REQUIRE(grid.entry_id(coord_def(-1, 0)) == 0);
+}
@@ -0,0 +1,158 @@
+#include <cstdio>
+
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "package.h"
+
+static vector<unsigned char> _chunk_data(int chunk, int round)
+{
+    vector<unsigned char> data(1000 + (chunk * 7919 + round * 31) % 20000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (i * (chunk + 1) + round) & 0xff;
+    return data;
+}
+
+static vector<unsigned char> _read_chunk(package &pkg, const string &name)
+{
+    chunk_reader rd(&pkg, name);
+    vector<char> data;
+    rd.read_all(data);
+    return vector<unsigned char>(data.begin(), data.end());
+}
+
+static void _write_and_reopen(bool async, save_codec codec = SAVE_CODEC_ZLIB)
+{
+    const char *filename = "test_package.sav";
+    const int chunks = 8, rounds = 10;
+
+    {
+        package pkg(filename, true, true);
+        save_compression comp;
+        comp.codec = codec;
+        pkg.set_compression(comp);
+        if (async)
+            pkg.start_async();
+
+        for (int round = 0; round < rounds; round++)
+        {
+            for (int c = 0; c < chunks; c++)
+            {
+                const string name = "c" + to_string(c);
+                pkg.write_chunk(name, _chunk_data(c, round));
+                REQUIRE(pkg.has_chunk(name));
+                // Reading straight back must see the write, queued or not.
+                REQUIRE(_read_chunk(pkg, name) == _chunk_data(c, round));
+            }
+            pkg.commit();
+        }
+    }
+
+    package pkg(filename, false);
+    for (int c = 0; c < chunks; c++)
+    {
+        REQUIRE(_read_chunk(pkg, "c" + to_string(c))
+                == _chunk_data(c, rounds - 1));
+    }
+    remove(filename);
+}
+
+static void _mix_codecs()
+{
+    const char *filename = "test_package.sav";
+    const int chunks = 6;
+    save_compression zstd;
+    zstd.codec = SAVE_CODEC_ZSTD;
+
+    {
+        package pkg(filename, true, true);
+        for (int c = 0; c < chunks; c++)
+            pkg.write_chunk("c" + to_string(c), _chunk_data(c, 0));
+    }
+    {
+        package pkg(filename, true);
+        pkg.set_compression(zstd);
+        for (int c = 0; c < chunks; c += 2)
+            pkg.write_chunk("c" + to_string(c), _chunk_data(c, 1));
+    }
+
+    package pkg(filename, false);
+    for (int c = 0; c < chunks; c++)
+    {
+        REQUIRE(_read_chunk(pkg, "c" + to_string(c))
+                == _chunk_data(c, c % 2 ? 0 : 1));
+    }
+    remove(filename);
+}
+
+// On a crash, what the background writer has queued is written out, but
+// only committed chunks survive.
+static void _drain_on_crash()
+{
+    const char *filename = "test_package.sav";
+
+    {
+        package pkg(filename, true, true);
+        pkg.start_async();
+        for (int round = 0; round < 2; round++)
+        {
+            pkg.write_chunk("a", _chunk_data(0, round));
+            pkg.commit();
+        }
+        // Never committed, so lost with the rest of the crashed game.
+        pkg.write_chunk("a", _chunk_data(0, 2));
+        pkg.write_chunk("b", _chunk_data(1, 2));
+
+        REQUIRE(pkg.drain_async_for_crash(SAVE_CRASH_DRAIN_MS));
+        // The process dies here without committing anything more.
+        pkg.abort();
+    }
+
+    package pkg(filename, false);
+    REQUIRE(_read_chunk(pkg, "a") == _chunk_data(0, 1));
+    REQUIRE_FALSE(pkg.has_chunk("b"));
+    remove(filename);
+}
+
+TEST_CASE( "Package chunks round-trip", "[single-file]" ) {
+
+    SECTION ("when written synchronously") {
+        _write_and_reopen(false);
+    }
+
+    SECTION ("when written by the background writer") {
+        _write_and_reopen(true);
+    }
+
+    SECTION ("when the game crashes with writes queued") {
+        _drain_on_crash();
+    }
+}
+
+TEST_CASE( "Package chunks in other codecs", "[single-file]" ) {
+
+    save_compression comp;
+    string error;
+    REQUIRE(parse_save_compression("zlib:9", comp, error));
+    REQUIRE(comp.codec == SAVE_CODEC_ZLIB);
+    REQUIRE(comp.level == 9);
+    REQUIRE_FALSE(parse_save_compression("zlib:10", comp, error));
+    REQUIRE_FALSE(parse_save_compression("lzma", comp, error));
+    REQUIRE(comp.level == 9);
+
+    if (!save_codec_available(SAVE_CODEC_ZSTD))
+        return;
+
+    SECTION ("when written synchronously") {
+        _write_and_reopen(false, SAVE_CODEC_ZSTD);
+    }
+
+    SECTION ("when written by the background writer") {
+        _write_and_reopen(true, SAVE_CODEC_ZSTD);
+    }
+
+    SECTION ("when mixed with zlib chunks") {
+        _mix_codecs();
+    }
+}
@@ -608,14 +608,19 @@ static void _handle_spectral_cloud(const cloud_struct& cloud)
 void manage_clouds()
 {
     // We can't iterate over env.cloud directly because _dissipate_cloud
-    // will remove this cloud and invalidate our iterator.
-    vector<cloud_struct *> cloud_ptrs;
+    // will remove this cloud and invalidate our iterator. Clouds can also
+    // be removed, and others made in their place, while handling others, so
+    // only handle those that still exist from the start of the pass.
+    vector<pair<coord_def, uint32_t>> cloud_ids;
+    cloud_ids.reserve(env.cloud.size());
     for (auto& entry : env.cloud)
-        cloud_ptrs.push_back(&entry.second);
+        cloud_ids.emplace_back(entry.first, env.cloud.entry_id(entry.first));
 
-    for (auto ptr : cloud_ptrs)
+    for (const auto &id : cloud_ids)
     {
-        cloud_struct& cloud = *ptr;
+        if (env.cloud.entry_id(id.first) != id.second)
+            continue;
+        cloud_struct& cloud = *cloud_at(id.first);
 
 #ifdef ASSERTS
         if (cell_is_solid(cloud.pos))
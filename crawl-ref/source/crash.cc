@@ -83,6 +83,8 @@ template <typename TO, typename FROM> TO nasty_cast(FROM f)
 #include "files.h"
 #include "initfile.h"
 #include "options.h"
+#include "package.h"
+#include "player.h"
 #include "state.h"
 #include "stringutil.h"
 #include "syscalls.h"
@@ -193,6 +195,11 @@ void crash_signal_handler(int sig_num)
         die_noline("Stuck game with 100%% CPU use\n");
 #endif
 
+    // Let the background save writer finish what's already queued, for a
+    // while, so the save is left at the last checkpoint the game reached.
+    if (you.save)
+        you.save->drain_async_for_crash(SAVE_CRASH_DRAIN_MS);
+
     do_crash_dump();
 
     // Now crash for real.
@@ -32,7 +32,8 @@ class TextDB
 public:
     // db_name is the savedir-relative name of the db file,
     // minus the "db" extension.
-    TextDB(const char* db_name, const char* dir, vector<string> files);
+    TextDB(const char* db_name, const char* dir, vector<string> files,
+           bool indexed = false);
     TextDB(TextDB *parent);
     ~TextDB() { shutdown(true); delete translation; }
     void init();
@@ -52,6 +53,7 @@ public:
     const char* const _db_name;
     string _directory;
     vector<string> _input_files;
+    bool _indexed;
     DBM* _db;
     string timestamp;
     TextDB *_parent;
@@ -67,6 +69,7 @@ static void _store_text_db(const string &in, DBM *db);
 static string _query_database(TextDB &db, string key, bool canonicalise_key,
                               bool run_lua, bool untranslated = false);
 static void _add_entry(DBM *db, const string &k, string &v);
+static void _store_search_index(DBM *db);
 
 static TextDB AllDBs[] =
 {
@@ -84,7 +87,7 @@ static TextDB AllDBs[] =
             "cards.txt",
             "commands.txt",
             "clouds.txt",
-            "status.txt" }),
+            "status.txt" }, true),
 
     TextDB("gamestart", "descript/",
           { "species.txt",
@@ -160,9 +163,11 @@ static string _db_cache_path(string db, const char *lang)
 // TextDB
 // ----------------------------------------------------------------------
 
-TextDB::TextDB(const char* db_name, const char* dir, vector<string> files)
+TextDB::TextDB(const char* db_name, const char* dir, vector<string> files,
+               bool indexed)
     : _db_name(db_name), _directory(dir), _input_files(files),
-      _db(nullptr), timestamp(""), _parent(0), translation(0)
+      _indexed(indexed), _db(nullptr), timestamp(""), _parent(0),
+      translation(0)
 {
 }
 
@@ -170,7 +175,8 @@ TextDB::TextDB(TextDB *parent)
     : _db_name(parent->_db_name),
       _directory(parent->_directory + Options.lang_name + "/"),
       _input_files(parent->_input_files), // FIXME: pointless copy
-      _db(nullptr), timestamp(""), _parent(parent), translation(nullptr)
+      _indexed(parent->_indexed), _db(nullptr), timestamp(""),
+      _parent(parent), translation(nullptr)
 {
 }
 
@@ -312,6 +318,8 @@ void TextDB::_regenerate_db()
             _store_text_db(full_input_path, _db);
         }
     }
+    if (_indexed)
+        _store_search_index(_db);
     _add_entry(_db, "TIMESTAMP", ts);
 
     dbm_close(_db);
@@ -356,6 +364,159 @@ static datum _database_fetch(DBM *database, const string &key)
     return result;
 }
 
+// Indexed databases also map each run of three lowercase ASCII characters
+// in an entry's key or body to the entries containing it. Entries are
+// numbered by their place in the sorted list of keys stored under
+// SEARCH_INDEX_KEYS, and each run's list of entries is stored under
+// SEARCH_INDEX_PREFIX plus the run, as the gaps between entry numbers.
+// Searching for a plain string then only has to look at the entries that
+// have all of its runs.
+#define SEARCH_INDEX_PREFIX "__index:"
+#define SEARCH_INDEX_KEYS "__index_keys"
+
+static void _add_search_trigrams(const string &text, set<string> &grams)
+{
+    const string lower = lowercase_string(text);
+    int ascii = 0; // how many ASCII characters other than \n end here
+    for (size_t i = 0; i < lower.size(); ++i)
+    {
+        const unsigned char c = lower[i];
+        ascii = c && c < 128 && c != '\n' ? ascii + 1 : 0;
+        if (ascii >= 3)
+            grams.insert(lower.substr(i - 2, 3));
+    }
+}
+
+static void _store_search_index(DBM *db)
+{
+    vector<string> keys;
+    for (datum dbKey = dbm_firstkey(db); dbKey.dptr != nullptr;
+         dbKey = dbm_nextkey(db))
+    {
+        string key((const char *)dbKey.dptr, dbKey.dsize);
+        if (key.find("__") == string::npos)
+            keys.push_back(key);
+    }
+    sort(keys.begin(), keys.end());
+
+    map<string, string> postings;
+    map<string, int> last_entry;
+    for (int i = 0, size = keys.size(); i < size; ++i)
+    {
+        const datum body = _database_fetch(db, keys[i]);
+        set<string> grams;
+        _add_search_trigrams(keys[i], grams);
+        _add_search_trigrams(string((const char *)body.dptr, body.dsize),
+                             grams);
+
+        for (const string &gram : grams)
+        {
+            auto last = last_entry.find(gram);
+            const int gap = last == last_entry.end() ? i : i - last->second;
+            postings[gram] += make_stringf("%d ", gap);
+            last_entry[gram] = i;
+        }
+    }
+
+    for (auto &entry : postings)
+        _add_entry(db, SEARCH_INDEX_PREFIX + entry.first, entry.second);
+    string key_list = join_strings(keys.begin(), keys.end(), "\n");
+    _add_entry(db, SEARCH_INDEX_KEYS, key_list);
+}
+
+/**
+ * Find the entries of an indexed database that might match a search.
+ *
+ * @param database  The database to look in.
+ * @param regex     The search; only plain strings of at least three ASCII
+ *                  characters can be looked up.
+ * @param[out] keys The keys of the entries containing every run of three
+ *                  characters in the search, in order.
+ * @return Whether the search could be looked up in the index.
+ */
+static bool _search_index_candidates(DBM *database, const string &regex,
+                                     vector<string> &keys)
+{
+    if (regex.size() < 3
+        || regex.find_first_of("\\^$.|?*+()[]{}") != string::npos
+        || any_of(regex.begin(), regex.end(),
+                  [](char c) { return (unsigned char) c >= 128; }))
+    {
+        return false;
+    }
+
+    const datum key_list = _database_fetch(database, SEARCH_INDEX_KEYS);
+    if (!key_list.dptr || !key_list.dsize)
+        return false;
+
+    set<string> grams;
+    _add_search_trigrams(regex, grams);
+
+    vector<int> entries;
+    bool first = true;
+    for (const string &gram : grams)
+    {
+        const datum posting = _database_fetch(database,
+                                              SEARCH_INDEX_PREFIX + gram);
+        vector<int> gram_entries;
+        int entry = 0;
+        if (posting.dptr)
+        {
+            for (const string &gap :
+                 split_string(" ", string((const char *)posting.dptr,
+                                          posting.dsize)))
+            {
+                entry += atoi(gap.c_str());
+                gram_entries.push_back(entry);
+            }
+        }
+
+        if (first)
+            entries.swap(gram_entries);
+        else
+        {
+            vector<int> both;
+            set_intersection(entries.begin(), entries.end(),
+                             gram_entries.begin(), gram_entries.end(),
+                             back_inserter(both));
+            entries.swap(both);
+        }
+        first = false;
+
+        if (entries.empty())
+            break;
+    }
+
+    const vector<string> all_keys =
+        split_string("\n", string((const char *)key_list.dptr,
+                                  key_list.dsize), false);
+    for (int entry : entries)
+        if (entry >= 0 && entry < (int) all_keys.size())
+            keys.push_back(all_keys[entry]);
+    return true;
+}
+
+// The keys to check for a search: the candidates from the search index if
+// there is one and the search is a plain string, otherwise every key.
+static vector<string> _database_search_keys(DBM *database,
+                                            const string &regex)
+{
+    vector<string> keys;
+    if (_search_index_candidates(database, regex, keys))
+        return keys;
+
+    // The search index's own rows are never results, so don't make callers
+    // fetch and match them.
+    for (datum dbKey = dbm_firstkey(database); dbKey.dptr != nullptr;
+         dbKey = dbm_nextkey(database))
+    {
+        string key((const char *)dbKey.dptr, dbKey.dsize);
+        if (!starts_with(key, "__"))
+            keys.push_back(move(key));
+    }
+    return keys;
+}
+
 static vector<string> _database_find_keys(DBM *database,
                                           const string &regex,
                                           bool ignore_case,
@@ -364,20 +525,14 @@ static vector<string> _database_find_keys(DBM *database,
     text_pattern             tpat(regex, ignore_case);
     vector<string> matches;
 
-    datum dbKey = dbm_firstkey(database);
-
-    while (dbKey.dptr != nullptr)
+    for (const string &key : _database_search_keys(database, regex))
     {
-        string key((const char *)dbKey.dptr, dbKey.dsize);
-
         if (tpat.matches(key)
             && key.find("__") == string::npos
             && (filter == nullptr || !(*filter)(key, "")))
         {
             matches.push_back(key);
         }
-
-        dbKey = dbm_nextkey(database);
     }
 
     return matches;
@@ -391,13 +546,9 @@ static vector<string> _database_find_bodies(DBM *database,
     text_pattern             tpat(regex, ignore_case);
     vector<string> matches;
 
-    datum dbKey = dbm_firstkey(database);
-
-    while (dbKey.dptr != nullptr)
+    for (const string &key : _database_search_keys(database, regex))
     {
-        string key((const char *)dbKey.dptr, dbKey.dsize);
-
-        datum dbBody = dbm_fetch(database, dbKey);
+        datum dbBody = _database_fetch(database, key);
         string body((const char *)dbBody.dptr, dbBody.dsize);
 
         if (tpat.matches(body)
@@ -406,8 +557,6 @@ static vector<string> _database_find_bodies(DBM *database,
         {
             matches.push_back(key);
         }
-
-        dbKey = dbm_nextkey(database);
     }
 
     return matches;
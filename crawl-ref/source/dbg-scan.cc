@@ -327,6 +327,13 @@ void debug_mons_scan()
         ASSERT(m->mid > 0);
         coord_def pos = m->pos();
 
+        if (!binary_search(env.mons_used.begin(), env.mons_used.end(), i))
+        {
+            mprf(MSGCH_ERROR, "Monster %s missing from the used slot list, "
+                              "midx = %d",
+                 m->full_name(DESC_PLAIN).c_str(), i);
+        }
+
         if (invalid_monster_type(m->type))
         {
             mprf(MSGCH_ERROR, "Bogus monster type %d at (%d, %d), midx = %d",
@@ -21,6 +21,28 @@ static int dlua_compiled_chunk_writer(lua_State *ls, const void *p,
     return 0;
 }
 
+// Lua 5.1 starts bytecode with a 12 byte header giving the Lua version and
+// the sizes of its types.
+static const size_t LUA_BYTECODE_HEADER_SIZE = 12;
+
+// The bytecode header of this build's Lua. Bytecode with a different header
+// was made by some other build, and can't be loaded.
+static const string &_lua_bytecode_header()
+{
+    static string header;
+    if (header.empty())
+    {
+        lua_stack_cleaner cln(dlua);
+        ostringstream out;
+        if (!luaL_loadstring(dlua, "")
+            && !lua_dump(dlua, dlua_compiled_chunk_writer, &out))
+        {
+            header = out.str().substr(0, LUA_BYTECODE_HEADER_SIZE);
+        }
+    }
+    return header;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // dlua_chunk
 
@@ -72,7 +94,15 @@ void dlua_chunk::write(writer& outf) const
         return;
     }
 
-    if (!compiled.empty())
+    if (!compiled.empty() && !chunk.empty())
+    {
+        // Keep the source as well, in case the bytecode is read by a build
+        // that can't load it.
+        marshallByte(outf, CT_PRECOMPILED);
+        marshallString4(outf, compiled);
+        marshallString4(outf, chunk);
+    }
+    else if (!compiled.empty())
     {
         marshallByte(outf, CT_COMPILED);
         marshallString4(outf, compiled);
@@ -101,6 +131,15 @@ void dlua_chunk::read(reader& inf)
     case CT_COMPILED:
         unmarshallString4(inf, compiled);
         break;
+    case CT_PRECOMPILED:
+        unmarshallString4(inf, compiled);
+        unmarshallString4(inf, chunk);
+        if (compiled.compare(0, LUA_BYTECODE_HEADER_SIZE,
+                             _lua_bytecode_header()))
+        {
+            compiled.clear();
+        }
+        break;
     }
     unmarshallString4(inf, file);
     first = unmarshallInt(inf);
@@ -178,6 +217,23 @@ int dlua_chunk::load(CLua &interp)
     return err;
 }
 
+/**
+ * Compile the chunk's source to bytecode, without running it, so that it
+ * will be written out along with the source and needn't be parsed again
+ * when read back.
+ *
+ * @return 0 on success (or if there was nothing to compile), else the Lua
+ *         error code; the error is kept for when the chunk is next loaded.
+ */
+int dlua_chunk::compile(CLua &interp)
+{
+    if (!compiled.empty() || empty())
+        return 0;
+
+    lua_stack_cleaner cln(interp);
+    return load(interp);
+}
+
 int dlua_chunk::run(CLua &interp)
 {
     int err = load(interp);
@@ -33,7 +33,8 @@ private:
     {
         CT_EMPTY,
         CT_SOURCE,
-        CT_COMPILED
+        CT_COMPILED,
+        CT_PRECOMPILED, // bytecode along with its source
     };
 
 private:
@@ -56,6 +57,7 @@ public:
     void set_chunk(const string &s);
 
     int load(CLua &interp);
+    int compile(CLua &interp);
     int run(CLua &interp);
     int load_call(CLua &interp, const char *function);
     void set_file(const string &s);
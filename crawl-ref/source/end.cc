@@ -167,6 +167,10 @@ NORETURN void end(int exit_code, bool print_error, const char *format, ...)
 {
     disable_other_crashes();
 
+    // Let anything still being saved in the background reach the disk.
+    if (you.save)
+        you.save->stop_async();
+
     // Let "error" go out of scope for valgrind's sake.
     {
         string error = print_error ? strerror(errno) : "";
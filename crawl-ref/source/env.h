@@ -6,6 +6,7 @@
 #include "cloud.h"
 #include "coord.h"
 #include "fprop.h"
+#include "grid-map.h"
 #include "map-cell.h"
 #include "mapmark.h"
 #include "monster.h"
@@ -29,6 +30,10 @@ struct crawl_environment
 
     FixedVector< item_def, MAX_ITEMS >       item;  // item list
     FixedVector< monster, MAX_MONSTERS+2 >   mons;  // monster list, plus anon
+    // Indices of the real mons slots that may hold a monster, in order, so
+    // that iterating over monsters needn't look at every slot. A slot is
+    // listed from when it is handed out or filled until it is reset.
+    vector<int>                              mons_used;
 
     feature_grid                             grid;  // terrain grid
     FixedArray<terrain_property_t, GXM, GYM> pgrid; // terrain properties
@@ -74,10 +79,10 @@ struct crawl_environment
     tile_flavour tile_default;
     vector<string> tile_names;
 
-    map<coord_def, cloud_struct> cloud;
+    grid_map<cloud_struct> cloud;
 
-    map<coord_def, shop_struct> shop; // shop list
-    map<coord_def, trap_def> trap; // trap list
+    grid_map<shop_struct> shop; // shop list
+    grid_map<trap_def> trap; // trap list
 
     FixedVector< monster_type, MAX_MONS_ALLOC > mons_alloc;
     map_markers                              markers;
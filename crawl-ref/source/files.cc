@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -124,6 +125,7 @@ static void _ghost_dprf(const char *format, ...)
 #endif
 
 static void _save_level(const level_id& lid);
+static void _load_level(const level_id &level);
 
 static bool _ghost_version_compatible(const save_version &version);
 
@@ -807,6 +809,55 @@ vector<player_save_info> find_all_saved_characters()
     return saved_characters;
 }
 
+// The paths of all save files, for all game types.
+vector<string> find_all_save_files()
+{
+    vector<string> files;
+    set<string> dirs;
+    for (int i = 0; i < NUM_GAME_TYPE; ++i)
+    {
+        unwind_var<game_type> gt(crawl_state.type, static_cast<game_type>(i));
+
+        string savedir = _get_savefile_directory();
+        if (dirs.count(savedir))
+            continue;
+        dirs.insert(savedir);
+
+        if (savedir.empty())
+            savedir = ".";
+        for (const string &filename : get_dir_files_sorted(savedir))
+            if (is_save_file_name(filename))
+                files.push_back(catpath(savedir, filename));
+    }
+    return files;
+}
+
+/**
+ * Set a save's compression from the options, and load the dictionary, if
+ * any, which is needed to read levels compressed with it.
+ */
+void set_save_compression(package *save)
+{
+    save_compression comp;
+    string error;
+    if (!parse_save_compression(Options.save_compression, comp, error))
+        mprf(MSGCH_ERROR, "Bad save_compression: %s.", error.c_str());
+
+    if (!Options.save_compression_dict.empty())
+    {
+        try
+        {
+            comp.dict = load_save_dictionary(Options.save_compression_dict);
+        }
+        catch (ext_fail_exception &fe)
+        {
+            mprf(MSGCH_ERROR, "Bad save_compression_dict: %s", fe.what());
+        }
+    }
+
+    save->set_compression(comp);
+}
+
 bool save_exists(const string& filename)
 {
     return file_exists(_get_savefile_directory() + filename);
@@ -1009,12 +1060,24 @@ void write_ghost_version(writer &outf)
         marshallInt(outf, 0);
 }
 
+static void _start_async_save()
+{
+    if (Options.async_save && !you.save->is_async())
+        you.save->start_async();
+}
+
 static void _write_tagged_chunk(const string &chunkname, tag_type tag)
 {
-    writer outf(you.save, chunkname);
+    _start_async_save();
+
+    // With asynchronous saving only the marshalling happens here.
+    vector<unsigned char> buf;
+    writer outf(&buf);
 
     write_save_version(outf, save_version::current());
     tag_write(tag, outf);
+    // Levels are much alike, and compress well with a dictionary.
+    you.save->write_chunk(chunkname, move(buf), tag == TAG_LEVEL);
 }
 
 static int _get_dest_stair_type(dungeon_feature_type stair_taken,
@@ -1698,31 +1761,12 @@ static bool _branch_pregenerates(branch_type b)
 }
 
 /**
-* Generate dungeon branches in a stable order until the level `stopping_point`
-* is found; `stopping_point` will be generated if it doesn't already exist. If
-* it does exist, the function is a noop.
-*
-* If `stopping_point` is not in the generation order, it will be generated on
-* its own.
-*
-* To generate all generatable levels, pass a level_id with NUM_BRANCHES as the
-* branch.
-*/
-bool pregen_dungeon(const level_id &stopping_point)
+ * Find the levels that still need to be built, in generation order, to reach
+ * the level `stopping_point`. A level_id with NUM_BRANCHES as the branch
+ * collects every generatable level.
+ */
+static vector<level_id> _pregen_sequence(const level_id &stopping_point)
 {
-    // TODO: the is_valid() check here doesn't look quite right to me, but so
-    // far I can't get it to break anything...
-    if (stopping_point.is_valid()
-        || stopping_point.branch != NUM_BRANCHES &&
-           is_random_subbranch(stopping_point.branch) && you.wizard)
-    {
-        if (you.save->has_chunk(stopping_point.describe()))
-            return false;
-
-        if (!_branch_pregenerates(stopping_point.branch))
-            return generate_level(stopping_point);
-    }
-
     vector<level_id> to_generate;
     bool at_end = false;
     for (auto br : branch_generation_order)
@@ -1763,6 +1807,36 @@ bool pregen_dungeon(const level_id &stopping_point)
         if (at_end)
             break;
     }
+    return to_generate;
+}
+
+/**
+* Generate dungeon branches in a stable order until the level `stopping_point`
+* is found; `stopping_point` will be generated if it doesn't already exist. If
+* it does exist, the function is a noop.
+*
+* If `stopping_point` is not in the generation order, it will be generated on
+* its own.
+*
+* To generate all generatable levels, pass a level_id with NUM_BRANCHES as the
+* branch.
+*/
+bool pregen_dungeon(const level_id &stopping_point)
+{
+    // TODO: the is_valid() check here doesn't look quite right to me, but so
+    // far I can't get it to break anything...
+    if (stopping_point.is_valid()
+        || stopping_point.branch != NUM_BRANCHES &&
+           is_random_subbranch(stopping_point.branch) && you.wizard)
+    {
+        if (you.save->has_chunk(stopping_point.describe()))
+            return false;
+
+        if (!_branch_pregenerates(stopping_point.branch))
+            return generate_level(stopping_point);
+    }
+
+    const vector<level_id> to_generate = _pregen_sequence(stopping_point);
 
     if (to_generate.size() == 0)
     {
@@ -1812,6 +1886,58 @@ bool pregen_dungeon(const level_id &stopping_point)
     }
 }
 
+/**
+ * Build the next level in the pregeneration order, if any, and then return
+ * to the level the player is on. This is meant to be called while the game is
+ * idle, waiting for a command: the levels are built in exactly the order that
+ * pregen_dungeon() would build them, using the same per-branch levelgen rngs,
+ * so the end result is the same as catching up on level entry, but the cost
+ * is paid while the player is reading the screen instead of on the stairs.
+ *
+ * @return whether a level was built.
+ */
+bool pregen_dungeon_step()
+{
+    if (!Options.background_pregen
+        || !crawl_state.game_standard_levelgen()
+        || crawl_state.generating_level
+        || !you.on_current_level
+        || !_branch_pregenerates(you.where_are_you))
+    {
+        return false;
+    }
+
+    const vector<level_id> to_generate
+        = _pregen_sequence(level_id(NUM_BRANCHES, -1));
+    if (to_generate.empty())
+        return false;
+
+    // be sure that AK start doesn't interfere with the builder
+    unwind_var<game_chapter> chapter(you.chapter, CHAPTER_ORB_HUNTING);
+    const level_id original = level_id::current();
+
+    // The builder resets these as if the player had left the level. They
+    // aren't saved with it, so keep them across the trip.
+    unwind_var<unsigned short> prev_targ(you.prev_targ);
+    unwind_var<coord_def> prev_grd_targ(you.prev_grd_targ);
+    unwind_var<vector<coord_def>> travel_trail(env.travel_trail);
+    travel_cache.update_excludes();
+
+    dprf("Background pregenerating %s",
+         to_generate[0].describe().c_str());
+    _save_level(original);
+    const bool generated = generate_level(to_generate[0]);
+    if (!you.level_visited(to_generate[0]))
+        travel_cache.erase_level_info(to_generate[0]);
+
+    // come back the way a level_excursion does.
+    _load_level(original);
+    travel_cache.set_level_excludes();
+    you.on_current_level = true;
+    env.markers.activate_all(false);
+    return generated;
+}
+
 static void _rescue_player_from_wall()
 {
     // n.b. you.wizmode_teleported_into_rock would be better, but it is not
@@ -2239,17 +2365,104 @@ static void _save_level(const level_id& lid)
 # define CHUNK(short, long) long
 #endif
 
-#define SAVEFILE(short, long, savefn)           \
-    do                                          \
-    {                                           \
-        writer w(you.save, CHUNK(short, long)); \
-        savefn(w);                              \
-    } while (false)
+// What was last written to each chunk of the current save by _save_chunk().
+struct saved_chunk
+{
+    bool saved = false;
+    // The owner's change counter at the time, if it keeps one...
+    unsigned int generation = 0;
+    // ...otherwise the marshalled contents.
+    vector<unsigned char> contents;
+};
+static map<string, saved_chunk> saved_chunks;
+
+static vector<save_chunk_stats> save_stats;
+
+static save_chunk_stats &_save_stats_for(const string &name)
+{
+    for (save_chunk_stats &st : save_stats)
+        if (st.name == name)
+            return st;
+    save_stats.emplace_back();
+    save_stats.back().name = name;
+    return save_stats.back();
+}
+
+void forget_saved_chunks()
+{
+    saved_chunks.clear();
+}
+
+/**
+ * Write a chunk of the game state to the current save, unless it hasn't
+ * changed since it was last written there.
+ *
+ * @param name       The chunk's name.
+ * @param generation The owner's change counter, or -1 if it doesn't keep
+ *                   one, in which case the chunk is marshalled and compared
+ *                   with what was last written instead; that still saves
+ *                   compressing and writing it.
+ * @param savefn     Marshals the chunk.
+ */
+static void _save_chunk(const string &name, int64_t generation,
+                        function<void (writer &)> savefn)
+{
+    saved_chunk &last = saved_chunks[name];
+    save_chunk_stats &st = _save_stats_for(name);
+    const bool present = last.saved && you.save->has_chunk(name);
+
+    if (present && generation >= 0 && last.generation == generation)
+    {
+        st.skipped++;
+        return;
+    }
+
+    const auto start = chrono::high_resolution_clock::now();
+
+    vector<unsigned char> buf;
+    writer w(&buf);
+    savefn(w);
+
+    if (present && generation < 0 && last.contents == buf)
+    {
+        st.skipped++;
+        return;
+    }
+
+    last.saved = true;
+    if (generation >= 0)
+    {
+        last.generation = generation;
+        last.contents.clear();
+    }
+    else
+        last.contents = buf;
+
+    st.written++;
+    st.bytes = buf.size();
+    you.save->write_chunk(name, move(buf));
+    st.usec += chrono::duration_cast<chrono::microseconds>(
+                    chrono::high_resolution_clock::now() - start).count();
+}
+
+#define SAVEFILE(short, long, savefn)                        \
+    _save_chunk(CHUNK(short, long), -1,                       \
+                [](writer &w) { savefn(w); })
+
+#define SAVEFILE_GEN(short, long, generation, savefn)        \
+    _save_chunk(CHUNK(short, long), generation,               \
+                [](writer &w) { savefn(w); })
 
 // Stack allocated string's go in separate function, so Valgrind doesn't
 // complain.
 static void _save_game_base()
 {
+    _start_async_save();
+
+    // Stashes and the travel cache are changed through references handed
+    // out all over, so rather than keep counters they're compared by
+    // contents.
+
     /* Stashes */
     SAVEFILE("st", "stashes", StashTrack.save);
 
@@ -2259,20 +2472,20 @@ static void _save_game_base()
 #endif
 
     /* kills */
-    SAVEFILE("kil", "kills", you.kills.save);
+    SAVEFILE_GEN("kil", "kills", you.kills.generation(), you.kills.save);
 
     /* travel cache */
     SAVEFILE("tc", "travel_cache", travel_cache.save);
 
     /* notes */
-    SAVEFILE("nts", "notes", save_notes);
+    SAVEFILE_GEN("nts", "notes", notes_generation(), save_notes);
 
     /* tutorial/hints mode */
     if (crawl_state.game_is_hints_tutorial())
         SAVEFILE("tut", "tutorial", save_hints);
 
     /* messages */
-    SAVEFILE("msg", "messages", save_messages);
+    SAVEFILE_GEN("msg", "messages", messages_generation(), save_messages);
 
     /* tile dolls (empty for ASCII)*/
 #ifdef USE_TILE
@@ -2354,6 +2567,11 @@ void save_game(bool leave_game, const char *farewellmsg)
                                 : "See you soon, " + you.your_name + "!");
 }
 
+const vector<save_chunk_stats> &get_save_chunk_stats()
+{
+    return save_stats;
+}
+
 // Saves the game without exiting.
 void save_game_state()
 {
@@ -2874,6 +3092,8 @@ static bool _restore_game(const string& filename)
     clear_message_store();
 
     you.save = new package((_get_savefile_directory() + filename).c_str(), true);
+    set_save_compression(you.save);
+    forget_saved_chunks();
 
     if (!_read_char_chunk(you.save))
     {
@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+class package;
 struct player_save_info;
 
 enum load_mode_type
@@ -66,6 +67,8 @@ bool check_mkdir(const string &what, string *dir, bool silent = false);
 
 // Find saved games for all game types.
 vector<player_save_info> find_all_saved_characters();
+vector<string> find_all_save_files();
+void set_save_compression(package *save);
 
 NORETURN void print_save_json(const char *name);
 
@@ -87,6 +90,7 @@ void update_portal_entrances();
 void reset_portal_entrances();
 bool generate_level(const level_id &l);
 bool pregen_dungeon(const level_id &stopping_point);
+bool pregen_dungeon_step();
 bool load_level(dungeon_feature_type stair_taken, load_mode_type load_mode,
                 const level_id& old_level);
 void delete_level(const level_id &level);
@@ -96,6 +100,20 @@ void save_game(bool leave_game, const char *bye = nullptr);
 // Save game without exiting (used when changing levels).
 void save_game_state();
 
+// How often each of the chunks outside the level and the player has been
+// written or skipped as unchanged by save_game(), and what writing it cost.
+struct save_chunk_stats
+{
+    string name;
+    int written = 0;
+    int skipped = 0;
+    size_t bytes = 0;   // marshalled size when last written
+    uint64_t usec = 0;  // total time spent marshalling and writing
+};
+const vector<save_chunk_stats> &get_save_chunk_stats();
+// Call whenever you.save is replaced, so nothing is skipped as already saved.
+void forget_saved_chunks();
+
 void write_save_version(writer &file, save_version version);
 save_version get_save_version(reader &file);
 
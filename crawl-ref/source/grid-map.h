@@ -0,0 +1,171 @@
+/**
+ * @file
+ * @brief A map from level cells to things, looked up through a slot grid.
+**/
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "coord-def.h"
+#include "defines.h"
+#include "fixedarray.h"
+
+/**
+ * Holds at most one T per cell of the level, with the interface of a
+ * map<coord_def, T> (which it replaced), but found through a grid of slots
+ * into a pool rather than by searching a tree.
+ *
+ * Like a map, iteration goes by coordinates (x, then y), adding or erasing
+ * entries doesn't move any others, and erasing only invalidates iterators
+ * and references to the erased entry. Freed pool entries are reused by
+ * later additions, so use entry_id() rather than an address to tell whether
+ * an entry is still the same one.
+ */
+template <class T> class grid_map
+{
+public:
+    typedef coord_def           key_type;
+    typedef T                   mapped_type;
+    typedef pair<coord_def, T>  value_type;
+
+private:
+    // Pool index plus one, so that 0 is an empty cell.
+    typedef int16_t slot_t;
+    COMPILE_CHECK(GXM * GYM < INT16_MAX);
+
+    template <class M, class V>
+    class iter
+    {
+    public:
+        iter(M *_gm, int _cell) : gm(_gm), cell(_cell) { skip(); }
+
+        V &operator*() const { return gm->pool[gm->slot_at(cell) - 1]; }
+        V *operator->() const { return &**this; }
+        iter &operator++()
+        {
+            ++cell;
+            skip();
+            return *this;
+        }
+        bool operator==(const iter &other) const { return cell == other.cell; }
+        bool operator!=(const iter &other) const { return cell != other.cell; }
+
+    private:
+        void skip()
+        {
+            while (cell < GXM * GYM && !gm->slot_at(cell))
+                ++cell;
+        }
+
+        M *gm;
+        int cell;
+    };
+
+public:
+    typedef iter<grid_map, value_type> iterator;
+    typedef iter<const grid_map, const value_type> const_iterator;
+
+    grid_map() : slots(0), n_entries(0), last_id(0) { }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, GXM * GYM); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, GXM * GYM); }
+
+    size_t size() const { return n_entries; }
+    bool empty() const { return !n_entries; }
+
+    iterator find(const coord_def &c)
+    {
+        return _in_grid(c) && slots(c) ? iterator(this, _cell(c)) : end();
+    }
+
+    const_iterator find(const coord_def &c) const
+    {
+        return _in_grid(c) && slots(c) ? const_iterator(this, _cell(c))
+                                       : end();
+    }
+
+    size_t count(const coord_def &c) const
+    {
+        return _in_grid(c) && slots(c);
+    }
+
+    /**
+     * Identify the entry at a cell.
+     *
+     * @param c  The cell.
+     * @return   A number that no other entry added to this map has had, or
+     *           0 if there is no entry at c. Assigning to an existing entry
+     *           keeps its id; erasing it and adding another doesn't.
+     */
+    uint32_t entry_id(const coord_def &c) const
+    {
+        return _in_grid(c) && slots(c) ? ids[slots(c) - 1] : 0;
+    }
+
+    T &operator[](const coord_def &c)
+    {
+        ASSERT(_in_grid(c));
+        slot_t &slot = slots(c);
+        if (!slot)
+        {
+            if (unused.empty())
+            {
+                pool.emplace_back();
+                ids.push_back(0);
+                slot = pool.size();
+            }
+            else
+            {
+                slot = unused.back();
+                unused.pop_back();
+            }
+            pool[slot - 1].first = c;
+            ids[slot - 1] = ++last_id;
+            n_entries++;
+        }
+        return pool[slot - 1].second;
+    }
+
+    size_t erase(const coord_def &c)
+    {
+        if (!_in_grid(c) || !slots(c))
+            return 0;
+
+        slot_t &slot = slots(c);
+        // Don't hold on to anything the value owns.
+        pool[slot - 1].second = T();
+        unused.push_back(slot);
+        slot = 0;
+        n_entries--;
+        return 1;
+    }
+
+    void clear()
+    {
+        slots.init(0);
+        pool.clear();
+        ids.clear();
+        unused.clear();
+        n_entries = 0;
+    }
+
+private:
+    static bool _in_grid(const coord_def &c)
+    {
+        return c.x >= 0 && c.x < GXM && c.y >= 0 && c.y < GYM;
+    }
+    static int _cell(const coord_def &c) { return c.x * GYM + c.y; }
+    slot_t slot_at(int cell) const { return slots[cell / GYM][cell % GYM]; }
+
+    FixedArray<slot_t, GXM, GYM> slots;
+    deque<value_type> pool;
+    vector<uint32_t> ids;   // entry_id() of each pool entry
+    vector<slot_t> unused;  // freed pool entries
+    size_t n_entries;
+    uint32_t last_id;
+};
@@ -49,6 +49,7 @@
 #include "state.h"
 #include "status.h"
 #include "stringutil.h"
+#include "syscalls.h"
 #ifdef USE_TILE
  #include "tilepick.h"
 #endif
@@ -63,7 +64,49 @@ using namespace ui;
 
 #define SCORE_VERSION "0.1"
 
-// enough memory allocated to snarf in the scorefile entries
+// The score file is an append-only xlog: an entry is never moved or
+// rewritten once written, so its byte offset identifies it for good. The
+// ranking lives in a small side index (the score file name plus ".idx")
+// holding the offsets of the best SCORE_FILE_ENTRIES entries, best first.
+// The index records how much of the score file it covers, so entries
+// appended by a process that died before updating it -- or an index that
+// has gone missing altogether, as with score files from older versions --
+// are picked up by rescanning just the uncovered tail of the file. Every
+// indexed entry is checked against the file when the index is loaded, and
+// the whole index is rebuilt if the file has been rewritten under it.
+//
+// Unlike in older versions, the score file itself is not in rank order:
+// anything reading it directly has to rank it (as hiscores_print_all() does
+// for standard input). Older versions only read its first SCORE_FILE_ENTRIES
+// lines, so they shouldn't share a score file with this one.
+//
+// The index is stored in native byte order; one written by a machine of
+// the other endianness fails the magic check and is simply rebuilt.
+
+#define SCORE_INDEX_MAGIC 0x58444953 // "SIDX"
+
+struct score_index_entry
+{
+    int64_t points;
+    int64_t offset;     // of the entry's line in the score file
+};
+
+struct score_index_header
+{
+    uint32_t magic;
+    uint32_t count;
+    int64_t covered;    // bytes of the score file reflected in the index
+};
+
+struct score_index
+{
+    int64_t covered = 0;
+    vector<score_index_entry> entries;
+};
+
+// The ranking of the score file, and the entries read from it so far
+// (filled in lazily, indexed by rank).
+static score_index hs_index;
 static unique_ptr<scorefile_entry> hs_list[SCORE_FILE_ENTRIES];
 static int hs_list_size = 0;
 static bool hs_list_initalized = false;
@@ -76,6 +119,13 @@ static time_t _parse_time(const string &st);
 static string _xlog_escape(const string &s);
 static string _xlog_unescape(const string &s);
 static vector<string> _xlog_split_fields(const string &s);
+static bool _hs_index_sync(FILE *scores, score_index &idx);
+static bool _hs_read_indexed(FILE *scores, const score_index_entry &e,
+                             scorefile_entry &dest);
+static int  _hs_index_insert(score_index &idx, const score_index_entry &e);
+static void _hs_index_save(const score_index &idx, int first);
+static void _hs_set_list(const score_index &idx);
+static const scorefile_entry &_hs_fetch(FILE *scores, int rank);
 
 static string _score_file_name()
 {
@@ -101,87 +151,41 @@ int hiscores_new_entry(const scorefile_entry &ne)
 {
     unwind_bool score_update(crawl_state.updating_scores, true);
 
-    FILE *scores;
-    int i;
-    bool inserted = false;
-    int newest_entry = -1;
-
-    // open highscore file (reading) -- nullptr is fatal!
-    //
-    // Opening as a+ instead of r+ to force an exclusive lock (see
-    // hs_open) and to create the file if it's not there already.
-    scores = _hs_open("a+", _score_file_name());
+    // Opening as a+ to force an exclusive lock (see hs_open), which also
+    // serialises updates to the index, and to create the file if it's not
+    // there already. Writes always go to the end of the file.
+    FILE *scores = _hs_open("a+", _score_file_name());
     if (scores == nullptr)
         end(1, true, "failed to open score file for writing");
 
-    // we're at the end of the file, seek back to beginning.
-    fseek(scores, 0, SEEK_SET);
-
-    // read highscore file, inserting new entry at appropriate point,
-    for (i = 0; i < SCORE_FILE_ENTRIES; i++)
-    {
-        hs_list[i].reset(new scorefile_entry);
-        if (_hs_read(scores, *hs_list[i]) == false)
-            break;
-
-        // compare points..
-        if (!inserted && ne.get_score() >= hs_list[i]->get_score())
-        {
-            newest_entry = i;           // for later printing
-            inserted = true;
-            // copy read entry to i+1th position
-            // Fixed a nasty overflow bug here -- Sharp
-            if (i+1 < SCORE_FILE_ENTRIES)
-            {
-                hs_list[i + 1] = move(hs_list[i]);
-                hs_list[i].reset(new scorefile_entry(ne));
-                i++;
-            }
-            else
-                *hs_list[i] = ne; // copy new entry to current position
-        }
-    }
-
-    // special case: lowest score, with room
-    if (!inserted && i < SCORE_FILE_ENTRIES)
-    {
-        newest_entry = i;
-        inserted = true;
-        // copy new entry
-        hs_list[i].reset(new scorefile_entry(ne));
-        i++;
-    }
+    score_index idx;
+    const bool stale = _hs_index_sync(scores, idx);
 
-    hs_list_size = i;
-    hs_list_initalized = true;
+    fseek(scores, 0, SEEK_END);
+    const score_index_entry added = { ne.get_score(), ftell(scores) };
+    const int newest_entry = _hs_index_insert(idx, added);
 
-    // If we've still not inserted it, it's not a highscore.
-    if (!inserted)
+    // As before, a score that doesn't make the list isn't kept here; the
+    // logfile has every game.
+    if (newest_entry != -1)
     {
-        _hs_close(scores);
-        return -1;
+        scorefile_entry se = ne;
+        _hs_write(scores, se);
+        if (fflush(scores))
+            end(1, true, "unable to write to scorefile");
+        idx.covered = ftell(scores);
     }
 
-    // The old code closed and reopened the score file, leading to a
-    // race condition where one Crawl process could overwrite the
-    // other's highscore. Now we truncate and rewrite the file without
-    // closing it.
-    if (ftruncate(fileno(scores), 0))
-        end(1, true, "unable to truncate scorefile");
-
-    rewind(scores);
-
-    // write scorefile entries.
-    for (i = 0; i < hs_list_size; i++)
-    {
-        _hs_write(scores, *hs_list[i]);
+    // Only the entries from the new one down have moved.
+    if (stale)
+        _hs_index_save(idx, 0);
+    else if (newest_entry != -1)
+        _hs_index_save(idx, newest_entry);
 
-        // Leave in memory. Does this anyway if !inserted.
-        // Can write cleanup function if nessicary??
-        // hs_list[i].reset(nullptr);
-    }
+    _hs_set_list(idx);
+    if (newest_entry != -1)
+        hs_list[newest_entry].reset(new scorefile_entry(ne));
 
-    // close scorefile.
     _hs_close(scores);
     return newest_entry;
 }
@@ -228,27 +232,20 @@ static void _hiscores_print_entry(const scorefile_entry &se,
     pf("%s", entry.c_str());
 }
 
-// Reads hiscores file to memory
+// Reads the hiscores ranking to memory. The entries themselves are read on
+// demand by _hs_fetch().
 void hiscores_read_to_memory()
 {
-    FILE *scores;
-    int i;
-
     // open highscore file (reading)
-    scores = _hs_open("r", _score_file_name());
+    FILE *scores = _hs_open("r", _score_file_name());
     if (scores == nullptr)
         return;
 
-    // read highscore file
-    for (i = 0; i < SCORE_FILE_ENTRIES; i++)
-    {
-        hs_list[i].reset(new scorefile_entry);
-        if (_hs_read(scores, *hs_list[i]) == false)
-            break;
-    }
-
-    hs_list_size = i;
-    hs_list_initalized = true;
+    // Readers only have a shared lock, so bring the index up to date in
+    // memory and leave fixing the file to the next writer.
+    score_index idx;
+    _hs_index_sync(scores, idx);
+    _hs_set_list(idx);
 
     //close off
     _hs_close(scores);
@@ -267,16 +264,37 @@ void hiscores_print_all(int display_count, int format)
         return;
     }
 
-    for (int entry = 0; display_count <= 0 || entry < display_count; ++entry)
+    vector<scorefile_entry> ranked;
+    if (scores == stdin)
     {
+        // Standard input can't be seeked or indexed, so read all of it and
+        // rank it here. As in the index, newer entries go first among equal
+        // scores.
         scorefile_entry se;
-        if (!_hs_read(scores, se))
-            break;
+        while (_hs_read(scores, se))
+            ranked.push_back(se);
+        stable_sort(ranked.rbegin(), ranked.rend(),
+                    [](const scorefile_entry &a, const scorefile_entry &b)
+                    {
+                        return a.get_score() > b.get_score();
+                    });
+    }
+    else
+    {
+        score_index idx;
+        _hs_index_sync(scores, idx);
+        ranked.resize(idx.entries.size());
+        for (unsigned int i = 0; i < idx.entries.size(); ++i)
+            _hs_read_indexed(scores, idx.entries[i], ranked[i]);
+    }
 
+    for (int entry = 0; (display_count <= 0 || entry < display_count)
+                        && entry < (int) ranked.size(); ++entry)
+    {
         if (format == -1)
-            printf("%s", se.raw_string().c_str());
+            printf("%s", ranked[entry].raw_string().c_str());
         else
-            _hiscores_print_entry(se, entry, format, printf);
+            _hiscores_print_entry(ranked[entry], entry, format, printf);
     }
 
     _hs_close(scores);
@@ -311,13 +329,17 @@ string hiscores_print_list(int display_count, int format, int newest_entry, int&
 
     const int finish = start + display_count;
 
+    // Entries never move in the score file, so the offsets in the ranking
+    // stay good even if other games have added scores since it was read.
+    FILE *scores = _hs_open("r", _score_file_name());
+
     for (i = start; i < finish && i < total_entries; i++)
     {
         // check for recently added entry
         if (i == newest_entry)
             ret += "<yellow>";
 
-        _hiscores_print_entry(*hs_list[i], i, format, [&ret](const char */*fmt*/, const char *s){
+        _hiscores_print_entry(_hs_fetch(scores, i), i, format, [&ret](const char */*fmt*/, const char *s){
             ret += string(s);
         });
 
@@ -326,6 +348,8 @@ string hiscores_print_list(int display_count, int format, int newest_entry, int&
             ret += "<lightgrey>";
     }
 
+    _hs_close(scores);
+
     start_out = start;
     return ret;
 }
@@ -461,18 +485,17 @@ void UIHiscoresMenu::_construct_hiscore_table()
     if (scores == nullptr)
         return;
 
-    int i;
+    score_index idx;
+    _hs_index_sync(scores, idx);
+    _hs_set_list(idx);
+
     // read highscore file
-    for (i = 0; i < SCORE_FILE_ENTRIES; i++)
-    {
-        hs_list[i].reset(new scorefile_entry);
-        if (_hs_read(scores, *hs_list[i]) == false)
-            break;
-    }
+    for (int i = 0; i < hs_list_size; i++)
+        _hs_fetch(scores, i);
 
     _hs_close(scores);
 
-    for (int j=0; j<i; j++)
+    for (int j = 0; j < hs_list_size; j++)
         _add_hiscore_row(*hs_list[j], j);
 }
 
@@ -650,6 +673,231 @@ static void _hs_write(FILE *scores, scorefile_entry &se)
     fprintf(scores, "%s", se.raw_string().c_str());
 }
 
+static string _hs_index_name()
+{
+    return _score_file_name() + ".idx";
+}
+
+static bool _hs_index_before(const score_index_entry &a,
+                             const score_index_entry &b)
+{
+    // Among equal scores the newest entry ranks first.
+    return a.points != b.points ? a.points > b.points : a.offset > b.offset;
+}
+
+/**
+ * Add an entry to the ranking, dropping the lowest one if the list is full.
+ *
+ * @param idx The ranking.
+ * @param e   The entry to add.
+ * @return    The entry's rank, or -1 if it didn't make the list.
+ */
+static int _hs_index_insert(score_index &idx, const score_index_entry &e)
+{
+    auto pos = lower_bound(idx.entries.begin(), idx.entries.end(), e,
+                           _hs_index_before);
+    const int rank = pos - idx.entries.begin();
+    if (rank >= SCORE_FILE_ENTRIES)
+        return -1;
+
+    idx.entries.insert(pos, e);
+    if (idx.entries.size() > SCORE_FILE_ENTRIES)
+        idx.entries.pop_back();
+    return rank;
+}
+
+static void _hs_index_load(score_index &idx)
+{
+    idx = score_index();
+
+    FILE *f = fopen_u(_hs_index_name().c_str(), "rb");
+    if (!f)
+        return;
+
+    score_index_header hdr;
+    if (fread(&hdr, sizeof hdr, 1, f) == 1
+        && hdr.magic == SCORE_INDEX_MAGIC
+        && hdr.count <= SCORE_FILE_ENTRIES)
+    {
+        idx.entries.resize(hdr.count);
+        if (fread(idx.entries.data(), sizeof(score_index_entry), hdr.count, f)
+            == hdr.count)
+        {
+            idx.covered = hdr.covered;
+        }
+        else
+            idx.entries.clear();
+    }
+
+    fclose(f);
+}
+
+/**
+ * Read the entry that an index entry points at, checking that it's still
+ * the one that was indexed. The score file may have been rewritten since:
+ * older versions sharing it sort and truncate it, and administrators edit
+ * it by hand.
+ *
+ * @param scores The open score file.
+ * @param e      The index entry.
+ * @param dest   [out] The entry read, or a blank one.
+ * @return       Whether e pointed at the start of an entry with its score.
+ */
+static bool _hs_read_indexed(FILE *scores, const score_index_entry &e,
+                             scorefile_entry &dest)
+{
+    dest.reset();
+    if (e.offset < 0)
+        return false;
+    if (e.offset > 0)
+    {
+        fseek(scores, e.offset - 1, SEEK_SET);
+        if (fgetc(scores) != '\n')
+            return false;
+    }
+    else
+        rewind(scores);
+
+    if (_hs_read(scores, dest) && dest.get_score() == e.points)
+        return true;
+    dest.reset();
+    return false;
+}
+
+// Add any entries in the score file past the end of what idx covers.
+static void _hs_index_scan(FILE *scores, score_index &idx)
+{
+    fseek(scores, idx.covered, SEEK_SET);
+
+    char inbuf[1300];
+    scorefile_entry se;
+    while (true)
+    {
+        const long offset = ftell(scores);
+        if (!fgets(inbuf, sizeof inbuf, scores))
+            break;
+
+        // Skip over anything unparseable rather than getting stuck on it.
+        se.reset();
+        if (se.parse(inbuf))
+            _hs_index_insert(idx, { se.get_score(), offset });
+        idx.covered = ftell(scores);
+    }
+}
+
+/**
+ * Read the ranking for the score file, bringing it up to date with any
+ * entries the saved index doesn't cover.
+ *
+ * @param scores The open and locked score file.
+ * @param idx    [out] The ranking.
+ * @return       Whether the saved index was out of date.
+ */
+static bool _hs_index_sync(FILE *scores, score_index &idx)
+{
+    _hs_index_load(idx);
+
+    fseek(scores, 0, SEEK_END);
+    const long size = ftell(scores);
+
+    // Covering more than there is means the file has been replaced. It may
+    // also have been rewritten at the same or a larger size, so check that
+    // every entry is still where the index says; if not, start again.
+    if (idx.covered > size)
+        idx = score_index();
+    scorefile_entry se;
+    for (const score_index_entry &e : idx.entries)
+    {
+        if (!_hs_read_indexed(scores, e, se))
+        {
+            idx = score_index();
+            break;
+        }
+    }
+    if (idx.covered == size)
+        return false;
+
+    _hs_index_scan(scores, idx);
+    return true;
+}
+
+/**
+ * Write the ranking out to the index file. The caller must hold the
+ * exclusive lock on the score file.
+ *
+ * @param idx   The ranking.
+ * @param first The first rank that changed since the index file was
+ *              last written.
+ */
+static void _hs_index_save(const score_index &idx, int first)
+{
+    const string name = _hs_index_name();
+    FILE *f = fopen_u(name.c_str(), "r+b");
+    if (!f)
+    {
+        f = fopen_u(name.c_str(), "w+b");
+        first = 0;
+    }
+    // The index can always be rebuilt, so failing to write it isn't fatal.
+    if (!f)
+    {
+        dprf("unable to write score index %s", name.c_str());
+        return;
+    }
+
+    // Mark the index empty while the entries are in flux, so that a crash
+    // part way through leaves it to be rebuilt rather than half-updated.
+    score_index_header hdr = { SCORE_INDEX_MAGIC, 0, 0 };
+    fwrite(&hdr, sizeof hdr, 1, f);
+    fflush(f);
+
+    fseek(f, sizeof hdr + first * sizeof(score_index_entry), SEEK_SET);
+    fwrite(idx.entries.data() + first, sizeof(score_index_entry),
+           idx.entries.size() - first, f);
+    fflush(f);
+
+    hdr.count = idx.entries.size();
+    hdr.covered = idx.covered;
+    rewind(f);
+    fwrite(&hdr, sizeof hdr, 1, f);
+    fclose(f);
+}
+
+// Make idx the current ranking, forgetting any entries read for the old one.
+static void _hs_set_list(const score_index &idx)
+{
+    hs_index = idx;
+    hs_list_size = hs_index.entries.size();
+    for (auto &entry : hs_list)
+        entry.reset();
+    hs_list_initalized = true;
+}
+
+// The entry with the given rank in the current ranking, reading it from
+// the score file if it hasn't been already.
+static const scorefile_entry &_hs_fetch(FILE *scores, int rank)
+{
+    ASSERT_RANGE(rank, 0, hs_list_size);
+    if (!hs_list[rank])
+    {
+        unique_ptr<scorefile_entry> se(new scorefile_entry);
+        if (scores && scores != stdin
+            && !_hs_read_indexed(scores, hs_index.entries[rank], *se))
+        {
+            // The score file was rewritten after the ranking was read, so
+            // read the ranking again. If the file is now shorter, this rank
+            // is left blank.
+            score_index idx;
+            _hs_index_sync(scores, idx);
+            _hs_set_list(idx);
+            if (rank < hs_list_size)
+                _hs_read_indexed(scores, hs_index.entries[rank], *se);
+        }
+        hs_list[rank] = move(se);
+    }
+    return *hs_list[rank];
+}
+
 static const char *kill_method_names[] =
 {
     "mon", "pois", "cloud", "beam", "lava", "water",
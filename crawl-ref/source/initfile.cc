@@ -220,6 +220,7 @@ const vector<GameOption*> game_options::build_options_list()
         new BoolGameOption(SIMPLE_NAME(travel_key_stop), true),
         new BoolGameOption(SIMPLE_NAME(travel_one_unsafe_move), false),
         new BoolGameOption(SIMPLE_NAME(dump_on_save), true),
+        new BoolGameOption(SIMPLE_NAME(async_save), false),
         new BoolGameOption(SIMPLE_NAME(rest_wait_both), false),
         new BoolGameOption(SIMPLE_NAME(rest_wait_ancestor), false),
         new BoolGameOption(SIMPLE_NAME(cloud_status), !is_tiles()),
@@ -311,6 +312,8 @@ const vector<GameOption*> game_options::build_options_list()
         new BoolGameOption(SIMPLE_NAME(newgame_after_quit), false),
         new StringGameOption(SIMPLE_NAME(map_file_name), ""),
         new StringGameOption(SIMPLE_NAME(save_dir), _get_save_path("saves/")),
+        new StringGameOption(SIMPLE_NAME(save_compression), "zlib"),
+        new StringGameOption(SIMPLE_NAME(save_compression_dict), ""),
         new StringGameOption(SIMPLE_NAME(morgue_dir),
                              _get_save_path("morgue/")),
 #endif
@@ -1047,6 +1050,7 @@ void game_options::reset_options()
 
     incremental_pregen = true;
     pregen_dungeon = false;
+    background_pregen = false;
 
     // set it to the .crawlrc default
     autopickups.reset();
@@ -2603,6 +2607,7 @@ void game_options::read_option_line(const string &str, bool runscript)
         && key != "item_slot"
         && key != "ability_slot"
         && key != "sound" && key != "hold_sound" && key != "sound_file_path"
+        && key != "save_compression_dict"
         && key.find("font") == string::npos)
     {
         lowercase(field);
@@ -3457,15 +3462,25 @@ void game_options::read_option_line(const string &str, bool runscript)
             pregen_dungeon = true;
             incremental_pregen = true; // still affects loading games not
                                        // started with full pregen
+            background_pregen = false;
 #endif
         }
         else if (field == "incremental")
         {
             pregen_dungeon = false;
             incremental_pregen = true;
+            background_pregen = false;
+        }
+        else if (field == "background")
+        {
+            // levels are generated in the incremental order, but ahead of
+            // time while the game is waiting for input.
+            pregen_dungeon = false;
+            incremental_pregen = true;
+            background_pregen = true;
         }
         else if (field == "false" || field == "classic")
-            pregen_dungeon = incremental_pregen = false;
+            pregen_dungeon = incremental_pregen = background_pregen = false;
         else
         {
             report_error("Unknown value '%s' for pregen_dungeon.",
@@ -3908,6 +3923,7 @@ enum commandline_option_type
     CLO_SAVE_JSON,
     CLO_GAMETYPES_JSON,
     CLO_EDIT_BONES,
+    CLO_CONVERT_SAVES,
 #ifdef USE_TILE_WEB
     CLO_WEBTILES_SOCKET,
     CLO_AWAIT_CONNECTION,
@@ -3926,7 +3942,7 @@ static const char *cmd_ops[] =
     "extra-opt-first", "extra-opt-last", "sprint-map", "edit-save",
     "print-charset", "tutorial", "wizard", "explore", "no-save", "gdb",
     "no-gdb", "nogdb", "throttle", "no-throttle", "playable-json",
-    "branches-json", "save-json", "gametypes-json", "bones",
+    "branches-json", "save-json", "gametypes-json", "bones", "convert-saves",
 #ifdef USE_TILE_WEB
     "webtiles-socket", "await-connection", "print-webtiles-options",
 #endif
@@ -4208,6 +4224,114 @@ static void _edit_save(int argc, char **argv)
     }
 }
 
+static bool _is_level_chunk(const string &chunk)
+{
+    try
+    {
+        level_id::parse_level_id(chunk);
+        return true;
+    }
+    catch (const bad_level_id &err)
+    {
+        return false;
+    }
+}
+
+static plen_t _compressed_size(package &save)
+{
+    plen_t size = 0;
+    for (const string &chunk : save.list_chunks())
+        size += save.get_chunk_compressed_length(chunk);
+    return size;
+}
+
+// Rewrite every chunk with the given compression, in place.
+static void _convert_save(const string &filename, const save_compression &comp)
+{
+    package save(filename.c_str(), true);
+    const plen_t old_size = _compressed_size(save);
+    save.set_compression(comp);
+
+    for (const string &chunk : save.list_chunks())
+    {
+        vector<char> data;
+        {
+            chunk_reader in(&save, chunk);
+            in.read_all(data);
+        }
+        save.write_chunk(chunk, vector<unsigned char>(data.begin(), data.end()),
+                         _is_level_chunk(chunk));
+    }
+    save.commit();
+
+    printf("%s: %u -> %u bytes\n", filename.c_str(), old_size,
+           _compressed_size(save));
+}
+
+static void _convert_saves(int argc, char **argv)
+{
+    if (argc < 1 || !strcmp(argv[0], "help"))
+    {
+        printf("Usage: crawl --convert-saves <codec>[:<level>] [--dict <file>] [<save>...]\n"
+               "Recompresses the given saves (by file or character name), or else all\n"
+               "saves, in place. <codec> is zlib or zstd; see save_compression. With\n"
+               "zstd, levels are compressed with the dictionary, if one is given; any\n"
+               "dictionary the saves already use must be given too.\n");
+        return;
+    }
+
+    save_compression comp;
+    string error;
+    if (!parse_save_compression(argv[0], comp, error))
+        FAIL("%s.\n", error.c_str());
+    argc--, argv++;
+
+    vector<string> files;
+    try
+    {
+        for (; argc > 0; argc--, argv++)
+        {
+            if (!strcmp(argv[0], "--dict"))
+            {
+                if (argc < 2)
+                    FAIL("--dict needs a file.\n");
+                comp.dict = load_save_dictionary(argv[1]);
+                argc--, argv++;
+                continue;
+            }
+            string filename = argv[0];
+            if (!file_exists(filename))
+                filename = get_savedir_filename(filename);
+            files.push_back(filename);
+        }
+    }
+    catch (ext_fail_exception &fe)
+    {
+        FAIL("Error: %s\n", fe.what());
+    }
+
+    if (files.empty())
+        files = find_all_save_files();
+
+    for (const string &filename : files)
+    {
+        try
+        {
+            _convert_save(filename, comp);
+        }
+        catch (ext_fail_exception &fe)
+        {
+            fprintf(stderr, "%s: %s\n", filename.c_str(), fe.what());
+        }
+        catch (game_ended_condition &ge) // another process is using the save
+        {
+            if (ge.exit_reason != game_exit::abort)
+                throw;
+            fprintf(stderr, "%s: in use, skipped\n", filename.c_str());
+        }
+    }
+}
+
 static save_version _read_bones_version(const string &filename)
 {
     reader inf(filename);
@@ -5055,6 +5179,10 @@ bool parse_args(int argc, char **argv, bool rc_only)
             _edit_bones(argc - current - 1, argv + current + 1);
             end(0);
 
+        case CLO_CONVERT_SAVES:
+            _convert_saves(argc - current - 1, argv + current + 1);
+            end(0);
+
         case CLO_SEED:
             if (!next_is_param)
             {
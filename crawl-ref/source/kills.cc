@@ -70,6 +70,8 @@ void KillMaster::save(writer& outf) const
 
 void KillMaster::load(reader& inf)
 {
+    changes++;
+
     const auto version = get_save_version(inf);
     const auto major = version.major, minor = version.minor;
 
@@ -94,6 +96,7 @@ void KillMaster::record_kill(const monster* mon, int killer, bool ispet)
         ispet            ? KC_FRIENDLY :
                            KC_OTHER;
     categorized_kills[kc].record_kill(mon);
+    changes++;
 }
 
 int KillMaster::total_kills() const
@@ -173,10 +173,14 @@ public:
     int total_kills() const;
 
     string kill_info() const;
+
+    // Changes whenever a kill is recorded, so saving can tell if it's needed.
+    unsigned int generation() const { return changes; }
 private:
     const char *category_name(kill_category kc) const;
 
     Kills categorized_kills[KC_NCATEGORIES];
+    unsigned int changes = 0;
 private:
     void add_kill_info(string &, vector<kill_exp> &,
                        int count, const char *c, bool separator) const;
@@ -5,9 +5,12 @@
 
 #include "l-libs.h"
 
+#include <chrono>
+
 #include "act-iter.h"
 #include "branch.h"
 #include "chardump.h"
+#include "cloud.h"
 #include "cluautil.h"
 #include "coordit.h"
 #include "dbg-util.h"
@@ -26,6 +29,7 @@
 #include "state.h"
 #include "stringutil.h"
 #include "tileview.h"
+#include "timed-effects.h"
 #include "unwind.h"
 #include "view.h"
 #include "wiz-dgn.h"
@@ -344,9 +348,10 @@ LUAFN(debug_check_uniques)
 
 LUAFN(debug_viewwindow)
 {
-    viewwindow(lua_toboolean(ls, 1));
+    const int changed = viewwindow_count_changes(lua_toboolean(ls, 1));
     update_screen();
-    return 0;
+    lua_pushnumber(ls, changed);
+    return 1;
 }
 
 LUAWRAP(debug_seen_monsters_react, seen_monsters_react())
@@ -524,6 +529,78 @@ LUAFN(debug_check_moncasts)
     return 1;
 }
 
+// Returns a list of tables (name, written, skipped, bytes, usec), one per
+// chunk saved by save_game() outside the level and the player.
+LUAFN(debug_save_chunk_stats)
+{
+    lua_newtable(ls);
+    int index = 0;
+    for (const save_chunk_stats &st : get_save_chunk_stats())
+    {
+        lua_newtable(ls);
+        lua_pushstring(ls, st.name.c_str());
+        lua_setfield(ls, -2, "name");
+        lua_pushnumber(ls, st.written);
+        lua_setfield(ls, -2, "written");
+        lua_pushnumber(ls, st.skipped);
+        lua_setfield(ls, -2, "skipped");
+        lua_pushnumber(ls, st.bytes);
+        lua_setfield(ls, -2, "bytes");
+        lua_pushnumber(ls, st.usec);
+        lua_setfield(ls, -2, "usec");
+        lua_rawseti(ls, -2, ++index);
+    }
+    return 1;
+}
+
+// Runs `turns` turns of cloud upkeep and monster actions on the current
+// level, and returns the milliseconds spent in each, and the number of
+// clouds left.
+LUAFN(debug_cloud_benchmark)
+{
+    const int turns = luaL_safe_checkint(ls, 1);
+    unwind_var<int> time_taken(you.time_taken, BASELINE_DELAY);
+
+    typedef chrono::high_resolution_clock clock;
+    chrono::duration<double, milli> cloud_ms(0), mons_ms(0);
+    for (int i = 0; i < turns; ++i)
+    {
+        const auto t0 = clock::now();
+        manage_clouds();
+        const auto t1 = clock::now();
+        handle_monsters();
+        const auto t2 = clock::now();
+        cloud_ms += t1 - t0;
+        mons_ms += t2 - t1;
+    }
+
+    lua_pushnumber(ls, cloud_ms.count());
+    lua_pushnumber(ls, mons_ms.count());
+    lua_pushnumber(ls, env.cloud.size());
+    return 3;
+}
+
+// Catches the current level up on `turns` turns spent away from it, as when
+// the player comes back to it, and returns the milliseconds that took and
+// the number of monsters left.
+LUAFN(debug_catchup_benchmark)
+{
+    const int turns = luaL_safe_checkint(ls, 1);
+
+    const auto start = chrono::high_resolution_clock::now();
+    update_level(turns * BASELINE_DELAY);
+    const chrono::duration<double, milli> ms =
+        chrono::high_resolution_clock::now() - start;
+
+    int count = 0;
+    for (monster_iterator mi; mi; ++mi)
+        count++;
+
+    lua_pushnumber(ls, ms.count());
+    lua_pushnumber(ls, count);
+    return 2;
+}
+
 const struct luaL_reg debug_dlib[] =
 {
 { "goto_place", debug_goto_place },
@@ -555,5 +632,8 @@ const struct luaL_reg debug_dlib[] =
 { "reset_rng", debug_reset_rng },
 { "get_rng_state", debug_get_rng_state },
 { "check_moncasts", debug_check_moncasts },
+{ "save_chunk_stats", debug_save_chunk_stats },
+{ "cloud_benchmark", debug_cloud_benchmark },
+{ "catchup_benchmark", debug_catchup_benchmark },
 { nullptr, nullptr }
 };
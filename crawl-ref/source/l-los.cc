@@ -5,12 +5,16 @@
 
 #include "l-libs.h"
 
+#include <chrono>
+
 #include "cluautil.h"
 #include "coord.h"
+#include "coordit.h"
 #include "losglobal.h"
 #include "los.h"
 #include "ray.h"
 #include "stringutil.h"
+#include "terrain.h"
 
 #define RAY_METATABLE "dgn.ray"
 
@@ -57,11 +61,80 @@ LUAFN(los_cell_see_cell)
     PLUARET(number, cell_see_cell(p, q, LOS_DEFAULT));
 }
 
+/*** Global LOS cache statistics.
+ * @treturn int lookups answered from the cache
+ * @treturn int lookups that had to compute LOS
+ * @treturn int cached bitmaps invalidated by terrain changes
+ * @treturn int bytes used by cached bitmaps
+ * @function cache_stats
+ */
+LUAFN(los_cache_stats)
+{
+    const los_cache_counters &stats = get_los_cache_stats();
+    lua_pushnumber(ls, stats.hits);
+    lua_pushnumber(ls, stats.misses);
+    lua_pushnumber(ls, stats.invalidated);
+    lua_pushnumber(ls, los_cache_size());
+    return 4;
+}
+
+#ifdef WIZARD
+/*** Time losight() against the reference ray-by-ray implementation.
+ * Computes default LOS from every non-solid cell of the current level,
+ * `iterations` times with each implementation.
+ * @tparam int iterations
+ * @treturn number milliseconds taken by losight()
+ * @treturn number milliseconds taken by the reference implementation
+ * @treturn int number of cells whose visibility differed
+ * @function benchmark
+ */
+LUAFN(los_benchmark)
+{
+    const int iterations = luaL_safe_checkint(ls, 1);
+
+    vector<coord_def> centers;
+    for (rectangle_iterator ri(0); ri; ++ri)
+        if (!cell_is_solid(*ri))
+            centers.push_back(*ri);
+
+    typedef chrono::high_resolution_clock clock;
+    chrono::duration<double, milli> fast_ms(0), ref_ms(0);
+    int mismatches = 0;
+    los_grid fast, ref;
+    for (const coord_def &c : centers)
+    {
+        const auto t0 = clock::now();
+        for (int i = 0; i < iterations; ++i)
+            losight(fast, c);
+        const auto t1 = clock::now();
+        for (int i = 0; i < iterations; ++i)
+            losight_reference(ref, c);
+        const auto t2 = clock::now();
+        fast_ms += t1 - t0;
+        ref_ms += t2 - t1;
+
+        for (int y = -LOS_MAX_RANGE; y <= LOS_MAX_RANGE; ++y)
+            for (int x = -LOS_MAX_RANGE; x <= LOS_MAX_RANGE; ++x)
+                if (fast(coord_def(x, y)) != ref(coord_def(x, y)))
+                    mismatches++;
+    }
+
+    lua_pushnumber(ls, fast_ms.count());
+    lua_pushnumber(ls, ref_ms.count());
+    lua_pushnumber(ls, mismatches);
+    return 3;
+}
+#endif
+
 const struct luaL_reg los_dlib[] =
 {
     { "findray", los_find_ray },
     { "make_ray", los_make_ray },
     { "cell_see_cell", los_cell_see_cell },
+    { "cache_stats", los_cache_stats },
+#ifdef WIZARD
+    { "benchmark", los_benchmark },
+#endif
     { nullptr, nullptr }
 };
 
@@ -30,10 +30,12 @@
 #include <term.h>
 #include <termios.h>
 #include <unistd.h>
+#include <unordered_map>
 
 #include "colour.h"
 #include "cio.h"
 #include "crash.h"
+#include "libutil.h"
 #include "state.h"
 #include "tiles-build-specific.h"
 #include "unicode.h"
@@ -680,6 +682,11 @@ int unixcurses_get_vi_key(int keyin)
 #define KPADAPP "\033[?1051l\033[?1052l\033[?1060l\033[?1061h"
 #define KPADCUR "\033[?1051l\033[?1052l\033[?1060l\033[?1061l"
 
+// curs_attr_fg() and curs_attr_bg() results, by colour and the other half
+// of the pair. They depend on the options and the default colours, which
+// are only picked up again by update_screen(), so that clears this.
+static unordered_map<uint32_t, curses_style> colour_styles;
+
 void console_startup()
 {
     termio_init();
@@ -816,6 +823,8 @@ void puttext(int x1, int y1, const crawl_view_buffer &vbuf)
 // C++ string class.  -- bwr
 void update_screen()
 {
+    colour_styles.clear();
+
     // In objstat and similar modes, there might not be a screen to update.
     if (stdscr)
     {
@@ -961,14 +970,24 @@ static curses_style curs_attr(COLOURS fg, COLOURS bg, bool adjust_background)
 static curses_style curs_attr_bg(int col)
 {
     BG_COL = static_cast<COLOURS>(col & 0x00ff);
-    return curs_attr_mapped(FG_COL, BG_COL, get_brand(col));
+
+    const uint32_t key = (col & 0xffff) | FG_COL << 16 | 1 << 24;
+    if (const curses_style *style = map_find(colour_styles, key))
+        return *style;
+    return colour_styles[key] = curs_attr_mapped(FG_COL, BG_COL,
+                                                 get_brand(col));
 }
 
 // see declaration
 static curses_style curs_attr_fg(int col)
 {
     FG_COL = static_cast<COLOURS>(col & 0x00ff);
-    return curs_attr_mapped(FG_COL, BG_COL, get_brand(col));
+
+    const uint32_t key = (col & 0xffff) | BG_COL << 16;
+    if (const curses_style *style = map_find(colour_styles, key))
+        return *style;
+    return colour_styles[key] = curs_attr_mapped(FG_COL, BG_COL,
+                                                 get_brand(col));
 }
 
 // see declaration
@@ -84,11 +84,27 @@ static blockrays_t blockrays;
 struct cellray;
 static FixedArray<vector<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> min_cellrays;
 
-// Temporary arrays used in losight() to track which rays
+// The same blocking information packed into fixed-size word arrays for
+// losight(): bit i of a ray mask stands for minimal cellray i. Fixed-size
+// masks keep losight() free of allocation and let the compiler unroll
+// (and vectorise, where the target supports it) the mask operations.
+#define LOS_RAY_WORDS 16
+typedef uint64_t ray_word;
+struct ray_mask
+{
+    ray_word w[LOS_RAY_WORDS];
+};
+static FixedArray<ray_mask, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> block_masks;
+// The cellrays ending in each cell.
+static FixedArray<ray_mask, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> end_masks;
+
+#ifdef WIZARD
+// Temporary arrays used in losight_reference() to track which rays
 // are blocked or have seen a smoke cloud.
 // Allocated when doing the precomputations.
 static bit_vector *dead_rays     = nullptr;
 static bit_vector *smoke_rays    = nullptr;
+#endif
 
 class quadrant_iterator : public rectangle_iterator
 {
@@ -102,8 +118,10 @@ public:
 
 void clear_rays_on_exit()
 {
+#ifdef WIZARD
     delete dead_rays;
     delete smoke_rays;
+#endif
     for (quadrant_iterator qi; qi; ++qi)
         delete blockrays(*qi);
 }
@@ -428,8 +446,26 @@ static void _create_blockrays()
     for (quadrant_iterator qi; qi; ++qi)
         delete all_blockrays(*qi);
 
+    // Pack the compressed blockrays and the ray ends into word masks.
+    ASSERT(n_min_rays <= LOS_RAY_WORDS * 64);
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        block_masks(*qi) = ray_mask();
+        end_masks(*qi) = ray_mask();
+    }
+    for (int i = 0; i < n_min_rays; ++i)
+    {
+        const ray_word bit = ray_word(1) << (i % 64);
+        for (quadrant_iterator qi; qi; ++qi)
+            if (blockrays(*qi)->get(i))
+                block_masks(*qi).w[i / 64] |= bit;
+        end_masks(cellray_ends[i]).w[i / 64] |= bit;
+    }
+
+#ifdef WIZARD
     dead_rays  = new bit_vector(n_min_rays);
     smoke_rays = new bit_vector(n_min_rays);
+#endif
 
     dprf("Cellrays: %d Fullrays: %u Minimal cellrays: %u",
           n_cellrays, (unsigned int)fullrays.size(), n_min_rays);
@@ -787,11 +823,145 @@ bool cell_see_cell_nocache(const coord_def& p1, const coord_def& p2)
 // after removing duplicates. That means that we need to do
 // around 22*100*4 ~ 9,000 memory reads + writes per LOS call on a
 // 32-bit system. Not too bad.
+// The opacity of the whole 17x17 window is read once into row bitmasks,
+// and the ray masks are fixed-size word arrays, so only opaque and smoky
+// cells cost anything, and visibility of a cell is one masked test over
+// the rays ending there.
 // IMPROVEMENTS:
 // Smoke will now only block LOS after two cells of smoke. This is
 // done by updating with a second array.
 
-static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy)
+#define LOS_WIDTH (2 * LOS_MAX_RANGE + 1)
+COMPILE_CHECK(LOS_WIDTH <= 32);
+
+// Opacity and bounds of the cells around a LOS center, as row bitmasks:
+// bit x + LOS_MAX_RANGE of row y + LOS_MAX_RANGE is cell (x, y) relative
+// to the center. Cells outside the bounds are left clear.
+struct los_window
+{
+    uint32_t inside[LOS_WIDTH];
+    uint32_t opaque[LOS_WIDTH];
+    uint32_t half[LOS_WIDTH];
+
+    los_window(const coord_def& center, const opacity_func& opc,
+               const circle_def& bounds)
+    {
+        for (int y = -LOS_MAX_RANGE; y <= LOS_MAX_RANGE; ++y)
+        {
+            uint32_t in = 0, opq = 0, hlf = 0;
+            for (int x = -LOS_MAX_RANGE; x <= LOS_MAX_RANGE; ++x)
+            {
+                const coord_def p(x, y);
+                if (!map_bounds(p + center) || !bounds.contains(p))
+                    continue;
+
+                const uint32_t bit = 1U << (x + LOS_MAX_RANGE);
+                in |= bit;
+                switch (opc(p + center))
+                {
+                case OPC_OPAQUE:
+                    opq |= bit;
+                    break;
+                case OPC_HALF:
+                    hlf |= bit;
+                    break;
+                default:
+                    break;
+                }
+            }
+            inside[y + LOS_MAX_RANGE] = in;
+            opaque[y + LOS_MAX_RANGE] = opq;
+            half[y + LOS_MAX_RANGE] = hlf;
+        }
+    }
+};
+
+static void _losight_quadrant(los_grid& sh, const los_window& win,
+                              int sx, int sy)
+{
+    ray_word dead[LOS_RAY_WORDS] = { 0 };
+    ray_word smoke[LOS_RAY_WORDS] = { 0 };
+
+    for (int qy = 0; qy <= LOS_MAX_RANGE; ++qy)
+    {
+        const int row = sy * qy + LOS_MAX_RANGE;
+        const uint32_t opaque = win.opaque[row];
+        const uint32_t half = win.half[row];
+        if (!(opaque | half))
+            continue;
+
+        for (int qx = 0; qx <= LOS_MAX_RANGE; ++qx)
+        {
+            const uint32_t bit = 1U << (sx * qx + LOS_MAX_RANGE);
+            const ray_word *block = block_masks[qx][qy].w;
+            if (opaque & bit)
+            {
+                // Block the appropriate rays.
+                for (int i = 0; i < LOS_RAY_WORDS; ++i)
+                    dead[i] |= block[i];
+            }
+            else if (half & bit)
+            {
+                // Block rays which have already seen a cloud.
+                for (int i = 0; i < LOS_RAY_WORDS; ++i)
+                {
+                    dead[i]  |= smoke[i] & block[i];
+                    smoke[i] |= block[i];
+                }
+            }
+        }
+    }
+
+    // Ray calculation done. A cell in this quadrant is visible if any
+    // cellray ending there is still alive.
+    for (int qy = 0; qy <= LOS_MAX_RANGE; ++qy)
+    {
+        const uint32_t inside = win.inside[sy * qy + LOS_MAX_RANGE];
+        if (!inside)
+            continue;
+
+        for (int qx = 0; qx <= LOS_MAX_RANGE; ++qx)
+        {
+            if (!(inside & (1U << (sx * qx + LOS_MAX_RANGE))))
+                continue;
+
+            const ray_word *ends = end_masks[qx][qy].w;
+            ray_word alive = 0;
+            for (int i = 0; i < LOS_RAY_WORDS; ++i)
+                alive |= ends[i] & ~dead[i];
+            if (alive)
+                sh(coord_def(sx * qx, sy * qy)) = true;
+        }
+    }
+}
+
+static const int quadrant_x[4] = {  1, -1, -1,  1 };
+static const int quadrant_y[4] = {  1,  1, -1, -1 };
+
+void losight(los_grid& sh, const coord_def& center,
+             const opacity_func& opc, const circle_def& bounds)
+{
+    sh.init(false);
+
+    // Do precomputations if necessary.
+    raycast();
+
+    const los_window win(center, opc, bounds);
+    for (int q = 0; q < 4; ++q)
+        _losight_quadrant(sh, win, quadrant_x[q], quadrant_y[q]);
+
+    // Center is always visible.
+    const coord_def o = coord_def(0,0);
+    sh(o) = true;
+}
+
+#ifdef WIZARD
+// The original one-ray-at-a-time implementation of losight(), kept to
+// check and benchmark the bitmask version against.
+static void _losight_quadrant_reference(los_grid& sh, const coord_def& center,
+                                        const opacity_func& opc,
+                                        const circle_def& bounds,
+                                        int sx, int sy)
 {
     const unsigned int num_cellrays = cellray_ends.size();
 
@@ -801,10 +971,10 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
     for (quadrant_iterator qi; qi; ++qi)
     {
         coord_def p = coord_def(sx*(qi->x), sy*(qi->y));
-        if (!dat.los_bounds(p))
+        if (!map_bounds(p + center) || !bounds.contains(p))
             continue;
 
-        switch (dat.opacity(p))
+        switch (opc(p + center))
         {
         case OPC_OPAQUE:
             // Block the appropriate rays.
@@ -830,54 +1000,27 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
             // This ray is alive, thus the end cell is visible.
             const coord_def p = coord_def(sx * cellray_ends[rayidx].x,
                                           sy * cellray_ends[rayidx].y);
-            if (dat.los_bounds(p))
+            if (map_bounds(p + center) && bounds.contains(p))
                 sh(p) = true;
         }
     }
 }
 
-struct los_param_funcs : public los_param
+void losight_reference(los_grid& sh, const coord_def& center,
+                       const opacity_func& opc, const circle_def& bounds)
 {
-    coord_def center;
-    const opacity_func& opc;
-    const circle_def& bounds;
-
-    los_param_funcs(const coord_def& c,
-                    const opacity_func& o, const circle_def& b)
-        : center(c), opc(o), bounds(b)
-    {
-    }
-
-    bool los_bounds(const coord_def& p) const override
-    {
-        return map_bounds(p + center) && bounds.contains(p);
-    }
-
-    opacity_type opacity(const coord_def& p) const override
-    {
-        return opc(p + center);
-    }
-};
-
-void losight(los_grid& sh, const coord_def& center,
-             const opacity_func& opc, const circle_def& bounds)
-{
-    const los_param& dat = los_param_funcs(center, opc, bounds);
-
     sh.init(false);
-
-    // Do precomputations if necessary.
     raycast();
 
-    const int quadrant_x[4] = {  1, -1, -1,  1 };
-    const int quadrant_y[4] = {  1,  1, -1, -1 };
     for (int q = 0; q < 4; ++q)
-        _losight_quadrant(sh, dat, quadrant_x[q], quadrant_y[q]);
+    {
+        _losight_quadrant_reference(sh, center, opc, bounds,
+                                    quadrant_x[q], quadrant_y[q]);
+    }
 
-    // Center is always visible.
-    const coord_def o = coord_def(0,0);
-    sh(o) = true;
+    sh(coord_def(0,0)) = true;
 }
+#endif
 
 opacity_type mons_opacity(const monster* mon, los_type how)
 {
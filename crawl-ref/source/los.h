@@ -46,6 +46,12 @@ void losight(los_grid& sh, const coord_def& center,
              const opacity_func &opc = opc_default,
              const circle_def &bds = BDS_DEFAULT);
 
+#ifdef WIZARD
+void losight_reference(los_grid& sh, const coord_def& center,
+                       const opacity_func &opc = opc_default,
+                       const circle_def &bds = BDS_DEFAULT);
+#endif
+
 void los_actor_moved(const actor* act, const coord_def& oldpos);
 void los_monster_died(const monster* mon);
 void los_terrain_changed(const coord_def& p);
@@ -4,128 +4,176 @@
 
 #include "coord.h"
 #include "coordit.h"
+#include "fixedarray.h"
 #include "libutil.h"
 #include "los-def.h"
 
-#define LOS_KNOWN 4
+// The global LOS cache keeps, for each cell that LOS has been asked about,
+// a bitmap of the cells it can see within LOS_MAX_RANGE. Bitmaps are
+// allocated per (source, los_type) pair on first use and kept in a pool
+// until the next full invalidation (e.g. on level change), so memory scales
+// with the number of sources actually queried rather than the map size.
 
-typedef uint8_t losfield_t;
-typedef losfield_t halflos_t[LOS_MAX_RANGE+1][2*LOS_MAX_RANGE+1];
-static const int o_half_x = 0;
-static const int o_half_y = LOS_MAX_RANGE;
-typedef halflos_t globallos_t[GXM][GYM];
+#define LOS_WIDTH (2 * LOS_MAX_RANGE + 1)
+#define NUM_LOS_TYPES 4
 
-static globallos_t globallos;
+COMPILE_CHECK(LOS_WIDTH <= 32);
+COMPILE_CHECK(NUM_LOS_TYPES * GXM * GYM < INT16_MAX);
 
-static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
+struct los_bitmap
 {
-    COMPILE_CHECK(LOS_KNOWN * 2 <= sizeof(losfield_t) * 8);
+    bool known;
+    // One row of the window per word, bit x for column x.
+    uint32_t rows[LOS_WIDTH];
 
-    if (!map_bounds(p) || !map_bounds(q))
-        return nullptr;
-    coord_def diff = q - p;
-    if (diff.rdist() > LOS_RADIUS)
-        return nullptr;
-    // p < q iff p.x < q.x || p.x == q.x && p.y < q.y
-    if (diff < coord_def(0, 0))
-        return &globallos[q.x][q.y][-diff.x + o_half_x][-diff.y + o_half_y];
-    else
-        return &globallos[p.x][p.y][ diff.x + o_half_x][ diff.y + o_half_y];
+    bool sees(const coord_def& diff) const
+    {
+        return rows[diff.y + LOS_MAX_RANGE] & (1U << (diff.x + LOS_MAX_RANGE));
+    }
+};
+
+// Index into los_pool plus one, so that the zero-initialised table is empty.
+static FixedArray<int16_t, GXM, GYM> los_slot[NUM_LOS_TYPES];
+static vector<los_bitmap> los_pool;
+
+static los_cache_counters cache_stats;
+
+static int _los_type_index(los_type l)
+{
+    switch (l)
+    {
+    case LOS_DEFAULT:   return 0;
+    case LOS_NO_TRANS:  return 1;
+    case LOS_SOLID:     return 2;
+    case LOS_SOLID_SEE: return 3;
+    default:
+        die("invalid opacity");
+    }
 }
 
-static void _save_los(los_def* los, los_type l)
+static los_bitmap *_find_bitmap(const coord_def& p, int idx)
 {
-    const coord_def o = los->get_center();
-    int y1 = o.y - LOS_MAX_RANGE;
-    int y2 = o.y + LOS_MAX_RANGE;
-    int x1 = o.x - LOS_MAX_RANGE;
-    int x2 = o.x + LOS_MAX_RANGE;
-    for (int y = y1; y <= y2; y++)
-        for (int x = x1; x <= x2; x++)
-        {
-            if (max(abs(o.x - x), abs(o.y - y)) > LOS_MAX_RANGE)
-                continue;
-
-            coord_def ri(x, y);
-            losfield_t* flags = _lookup_globallos(o, ri);
-            if (!flags)
-                continue;
-            *flags |= l << LOS_KNOWN;
-            if (los->see_cell(ri))
-                *flags |= l;
-            else
-                *flags &= ~l;
-        }
+    const int16_t slot = los_slot[idx](p);
+    return slot ? &los_pool[slot - 1] : nullptr;
+}
+
+static los_bitmap &_get_bitmap(const coord_def& p, int idx)
+{
+    int16_t &slot = los_slot[idx](p);
+    if (!slot)
+    {
+        los_pool.emplace_back();
+        los_pool.back().known = false;
+        slot = los_pool.size();
+    }
+    return los_pool[slot - 1];
+}
+
+static void _save_los(const los_def& los, los_bitmap &bm)
+{
+    const coord_def o = los.get_center();
+    for (int dy = -LOS_MAX_RANGE; dy <= LOS_MAX_RANGE; dy++)
+    {
+        uint32_t row = 0;
+        for (int dx = -LOS_MAX_RANGE; dx <= LOS_MAX_RANGE; dx++)
+            if (los.see_cell(o + coord_def(dx, dy)))
+                row |= 1U << (dx + LOS_MAX_RANGE);
+        bm.rows[dy + LOS_MAX_RANGE] = row;
+    }
+    bm.known = true;
 }
 
 // Opacity at p has changed.
+//
+// Only sources that could see p need to be recomputed: if p was not visible
+// from a source, every ray from that source through p was already blocked
+// before reaching p, so p's opacity can't matter to it.
 void invalidate_los_around(const coord_def& p)
 {
-    int x1 = max(p.x - LOS_MAX_RANGE, 0);
-    int y1 = max(p.y - LOS_MAX_RANGE, 0);
-    int x2 = min(p.x, GXM - 1);
-    int y2 = min(p.y + LOS_MAX_RANGE, GYM - 1);
-    for (int y = y1; y <= y2; y++)
-        for (int x = x1; x <= x2; x++)
-            memset(globallos[x][y], 0, sizeof(halflos_t));
+    if (los_pool.empty())
+        return;
+
+    for (rectangle_iterator ri(p, LOS_MAX_RANGE, true); ri; ++ri)
+    {
+        const coord_def diff = p - *ri;
+        for (int idx = 0; idx < NUM_LOS_TYPES; idx++)
+        {
+            los_bitmap *bm = _find_bitmap(*ri, idx);
+            if (bm && bm->known && bm->sees(diff))
+            {
+                bm->known = false;
+                cache_stats.invalidated++;
+            }
+        }
+    }
 }
 
 void invalidate_los()
 {
-    for (rectangle_iterator ri(0); ri; ++ri)
-        memset(globallos[ri->x][ri->y], 0, sizeof(halflos_t));
+    for (int idx = 0; idx < NUM_LOS_TYPES; idx++)
+        los_slot[idx].init(0);
+    los_pool.clear();
 }
 
-static void _update_globallos_at(const coord_def& p, los_type l)
+static const opacity_func &_los_opacity(los_type l)
 {
     switch (l)
     {
-    case LOS_DEFAULT:
-        {
-            los_def los(p, opc_default);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
-    case LOS_NO_TRANS:
-        {
-            los_def los(p, opc_no_trans);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
-    case LOS_SOLID:
-        {
-            los_def los(p, opc_solid);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
-    case LOS_SOLID_SEE:
-        {
-            los_def los(p, opc_solid_see);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
+    case LOS_DEFAULT:   return opc_default;
+    case LOS_NO_TRANS:  return opc_no_trans;
+    case LOS_SOLID:     return opc_solid;
+    case LOS_SOLID_SEE: return opc_solid_see;
     default:
         die("invalid opacity");
     }
 }
 
+static const los_bitmap &_update_globallos_at(const coord_def& p, los_type l)
+{
+    los_def los(p, _los_opacity(l));
+    los.update();
+    los_bitmap &bm = _get_bitmap(p, _los_type_index(l));
+    _save_los(los, bm);
+    return bm;
+}
+
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
 {
     if (l == LOS_NONE)
         return true;
 
-    losfield_t* flags = _lookup_globallos(p, q);
-
-    if (!flags)
+    if (!map_bounds(p) || !map_bounds(q))
+        return false;
+    const coord_def diff = q - p;
+    if (diff.rdist() > LOS_RADIUS)
         return false; // outside range
 
-    if (!(*flags & (l << LOS_KNOWN)))
-        _update_globallos_at(p, l);
+    const int idx = _los_type_index(l);
+
+    // LOS is symmetric, so either end can answer.
+    const los_bitmap *bm = _find_bitmap(p, idx);
+    if (bm && bm->known)
+    {
+        cache_stats.hits++;
+        return bm->sees(diff);
+    }
+    bm = _find_bitmap(q, idx);
+    if (bm && bm->known)
+    {
+        cache_stats.hits++;
+        return bm->sees(-diff);
+    }
 
-    ASSERT(*flags & (l << LOS_KNOWN));
-    return *flags & l;
+    cache_stats.misses++;
+    return _update_globallos_at(p, l).sees(diff);
+}
+
+const los_cache_counters &get_los_cache_stats()
+{
+    return cache_stats;
+}
+
+size_t los_cache_size()
+{
+    return los_pool.size() * sizeof(los_bitmap);
 }
@@ -2,7 +2,17 @@
 
 #include "los-type.h"
 
+struct los_cache_counters
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidated = 0;
+};
+
 void invalidate_los_around(const coord_def& p);
 void invalidate_los();
 
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l);
+
+const los_cache_counters &get_los_cache_stats();
+size_t los_cache_size();
@@ -159,20 +159,3 @@ public:
     opacity_type operator()(const coord_def& p) const override;
 };
 extern const opacity_excl opc_excl;
-
-// Subclasses of this are passed to losight() to modify the
-// LOS calculation. Implementations will have to translate between
-// relative coordinates (-8,-8)..(8,8) and real coordinates,
-// specify how opaque the cells are and determine what values
-// are written to the visible cells.
-class los_param
-{
-public:
-    virtual ~los_param() {}
-
-    // Whether the translated coordinate lies within the map
-    // (including boundary) and within the LOS area
-    virtual bool los_bounds(const coord_def& p) const = 0;
-
-    virtual opacity_type opacity(const coord_def& p) const = 0;
-};
@@ -358,7 +358,8 @@ static void _reset_game()
     clear_level_target();
     overview_clear();
     clear_message_window();
-    note_list.clear();
+    clear_notes();
+    forget_saved_chunks();
     msg::deinitialise_mpr_streams();
 
 #ifdef USE_TILE_LOCAL
@@ -496,6 +497,8 @@ static void _show_commandline_options_help()
     puts("  -macro <dir>          directory to save/find macro.txt");
     puts("  -version              Crawl version (and compilation info)");
     puts("  -save-version <name>  Save file version for the given player");
+    puts("  -convert-saves <codec> [<save>...]");
+    puts("                        recompress saves; see save_compression");
     puts("  -sprint               select Sprint");
     puts("  -sprint-map <name>    preselect a Sprint map");
     puts("  -tutorial             select the Tutorial");
@@ -1130,6 +1133,11 @@ static void _input()
         // Flush messages and display message window.
         msgwin_new_cmd();
 
+        // While the player is looking at the screen, get ahead on building
+        // levels for background pregeneration.
+        while (!has_pending_input() && !kbhit() && pregen_dungeon_step())
+            ;
+
         crawl_state.waiting_for_command = true;
         c_input_reset(true);
 
@@ -2250,7 +2258,16 @@ void world_reacts()
 
     abyss_morph();
     apply_noises();
+    reset_tracer_cache_counts();
     handle_monsters(true);
+#ifdef DEBUG_DIAGNOSTICS
+    const tracer_cache_stats tracers = tracer_cache_counts();
+    if (tracers.hits || tracers.misses)
+    {
+        dprf("Monster tracers: %d reused, %d fired", tracers.hits,
+             tracers.misses);
+    }
+#endif
 
     _check_banished();
 
@@ -2456,6 +2456,20 @@ void map_def::strip()
     feat_renames.clear();
 }
 
+/**
+ * Compile all of the map's Lua chunks, so that they are cached as bytecode
+ * and don't need parsing whenever the map is loaded from the cache.
+ */
+void map_def::precompile_lua()
+{
+    prelude.compile(dlua);
+    mapchunk.compile(dlua);
+    main.compile(dlua);
+    validate.compile(dlua);
+    veto.compile(dlua);
+    epilogue.compile(dlua);
+}
+
 void map_def::load()
 {
     if (!index_only)
@@ -758,8 +758,10 @@ private:
     };
 
 public:
-    bool accept(const map_def &md) const;
+    bool accept_static(const map_def &md) const;
+    bool accept_dynamic(const map_def &md) const;
     void announce(const map_def *map) const;
+    string cache_key() const;
 
     bool valid() const
     {
@@ -837,9 +839,7 @@ bool map_selector::depth_selectable(const map_def &mapdef) const
            && !mapdef.has_tag("place_unique")
            && !mapdef.has_tag("tutorial")
            && (!mapdef.has_tag_prefix("temple_")
-               || mapdef.has_tag_prefix("uniq_altar_"))
-           && _map_matches_species(mapdef)
-           && (!check_layout || _map_matches_layout_type(mapdef));
+               || mapdef.has_tag_prefix("uniq_altar_"));
 }
 
 static bool _is_extra_compatible(maybe_bool want_extra, bool have_extra)
@@ -849,22 +849,17 @@ static bool _is_extra_compatible(maybe_bool want_extra, bool have_extra)
            || (want_extra == MB_FALSE && !have_extra);
 }
 
-bool map_selector::accept(const map_def &mapdef) const
+// Map acceptance is split in two: this part depends only on the map and the
+// selector, so it can be cached for as long as the set of loaded maps stays
+// the same; accept_dynamic() checks the rest.
+bool map_selector::accept_static(const map_def &mapdef) const
 {
     switch (sel)
     {
     case PLACE:
-        if (mapdef.has_tag_prefix("tutorial")
-            && (!crawl_state.game_is_tutorial()
-                || !mapdef.has_tag(crawl_state.map)))
-        {
-            return false;
-        }
         return mapdef.is_minivault() == mini
                && _is_extra_compatible(extra, mapdef.is_extra_vault())
-               && mapdef.place.is_usable_in(place)
-               && _map_matches_layout_type(mapdef)
-               && !mapdef.map_already_used();
+               && mapdef.place.is_usable_in(place);
 
     case DEPTH:
     {
@@ -872,8 +867,7 @@ bool map_selector::accept(const map_def &mapdef) const
         return mapdef.is_minivault() == mini
                && _is_extra_compatible(extra, mapdef.is_extra_vault())
                && (!chance.valid() || mapdef.has_tag("dummy"))
-               && depth_selectable(mapdef)
-               && !mapdef.map_already_used();
+               && depth_selectable(mapdef);
     }
 
     case DEPTH_AND_CHANCE:
@@ -883,16 +877,44 @@ bool map_selector::accept(const map_def &mapdef) const
         return chance.valid()
                && !mapdef.has_tag("dummy")
                && depth_selectable(mapdef)
-               && _is_extra_compatible(extra, mapdef.is_extra_vault())
-               && !mapdef.map_already_used();
+               && _is_extra_compatible(extra, mapdef.is_extra_vault());
     }
 
     case TAG:
         return mapdef.has_all_tags(tag) // allow multiple tags, for temple overflow vaults
                && (!check_depth
                    || !mapdef.has_depth()
-                   || mapdef.is_usable_in(place))
-               && _map_matches_species(mapdef)
+                   || mapdef.is_usable_in(place));
+
+    default:
+        return false;
+    }
+}
+
+// The part of map selection that depends on the game in progress: the
+// player's species, the current level's layout, and which maps have been used.
+bool map_selector::accept_dynamic(const map_def &mapdef) const
+{
+    switch (sel)
+    {
+    case PLACE:
+        if (mapdef.has_tag_prefix("tutorial")
+            && (!crawl_state.game_is_tutorial()
+                || !mapdef.has_tag(crawl_state.map)))
+        {
+            return false;
+        }
+        return _map_matches_layout_type(mapdef)
+               && !mapdef.map_already_used();
+
+    case DEPTH:
+    case DEPTH_AND_CHANCE:
+        return _map_matches_species(mapdef)
+               && (!check_layout || _map_matches_layout_type(mapdef))
+               && !mapdef.map_already_used();
+
+    case TAG:
+        return _map_matches_species(mapdef)
                && _map_matches_layout_type(mapdef)
                && !mapdef.map_already_used();
 
@@ -901,6 +923,12 @@ bool map_selector::accept(const map_def &mapdef) const
     }
 }
 
+string map_selector::cache_key() const
+{
+    return make_stringf("%d:%s:%d:%d:%d:%s", sel, place.describe().c_str(),
+                        mini, extra, check_depth, tag.c_str());
+}
+
 void map_selector::announce(const map_def *vault) const
 {
 #ifdef DEBUG_DIAGNOSTICS
@@ -943,14 +971,32 @@ string vault_chance_tag(const map_def &map)
 
 typedef vector<unsigned> vault_indices;
 
+// Maps that pass map_selector::accept_static(), keyed by
+// map_selector::cache_key(). This has to be cleared whenever vdefs changes.
+static map<string, vault_indices> candidate_cache;
+
+static const vault_indices &_static_candidates(const map_selector &sel)
+{
+    const string key = sel.cache_key();
+    auto cached = candidate_cache.find(key);
+    if (cached != candidate_cache.end())
+        return cached->second;
+
+    vault_indices &candidates = candidate_cache[key];
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+        if (sel.accept_static(vdefs[i]))
+            candidates.push_back(i);
+    return candidates;
+}
+
 static vault_indices _eligible_maps_for_selector(const map_selector &sel)
 {
     vault_indices eligible;
 
     if (sel.valid())
     {
-        for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
-            if (sel.accept(vdefs[i]))
+        for (unsigned i : _static_candidates(sel))
+            if (sel.accept_dynamic(vdefs[i]))
                 eligible.push_back(i);
     }
 
@@ -1309,6 +1355,7 @@ static bool _load_map_index(const string& cache, const string &base,
 
     const int nmaps = unmarshallShort(inf);
     const int nexist = vdefs.size();
+    candidate_cache.clear();
     vdefs.resize(nexist + nmaps, map_def());
     for (int i = 0; i < nmaps; ++i)
     {
@@ -1361,6 +1408,7 @@ static void _write_map_prelude(const string &filebase, time_t mtime)
     write_save_version(outf, save_version::current());
     marshallByte(outf, WORD_LEN);
     marshallSigned(outf, mtime);
+    lc_global_prelude.compile(dlua);
     lc_global_prelude.write(outf);
     fclose(fp);
 }
@@ -1378,7 +1426,10 @@ static void _write_map_full(const string &filebase, size_t vs, size_t ve,
     marshallByte(outf, WORD_LEN);
     marshallSigned(outf, mtime);
     for (size_t i = vs; i < ve; ++i)
+    {
+        vdefs[i].precompile_lua();
         vdefs[i].write_full(outf);
+    }
     fclose(fp);
 }
 
@@ -1493,6 +1544,7 @@ void reread_maps()
 
     // BOOM!
     vdefs.clear();
+    candidate_cache.clear();
     map_files_read.clear();
     read_maps();
 }
@@ -1512,6 +1564,7 @@ void add_parsed_map(const map_def &md)
 
     map.fixup();
     vdefs.push_back(map);
+    candidate_cache.clear();
 }
 
 void run_map_global_preludes()
@@ -108,6 +108,11 @@ struct message_line
     int                 turn;
     bool                join;          /// may we merge this message w/others?
 
+    // full_text() as wrapped for the message history. Stored lines never
+    // change, so this only needs redoing if the width does.
+    mutable vector<formatted_string> history;
+    mutable int         history_width = -1;
+
     message_line() : channel(NUM_MESSAGE_CHANNELS), param(0), turn(-1),
                      join(true)
     {
@@ -230,6 +235,23 @@ struct message_line
     {
         return formatted_string::parse_string(full_text()).tostring();
     }
+
+    /// The lines to show for this message in the history, at this width.
+    const vector<formatted_string> &history_lines(int width) const
+    {
+        if (width != history_width)
+        {
+            history.clear();
+            string text = full_text();
+            if (!text.empty())
+            {
+                linebreak_string(text, width);
+                formatted_string::parse_string_to_multiple(text, history, 80);
+            }
+            history_width = width;
+        }
+        return history;
+    }
 };
 
 static int _mod(int num, int denom)
@@ -753,6 +775,7 @@ typedef circ_vec<message_line, NUM_STORED_MESSAGES> store_t;
 class message_store
 {
     store_t msgs;
+    unsigned int msgs_changed;
     message_line prev_msg;
     bool last_of_turn;
     int temp; // number of temporary messages
@@ -764,7 +787,7 @@ class message_store
 #endif
 
 public:
-    message_store() : last_of_turn(false), temp(0)
+    message_store() : msgs_changed(0), last_of_turn(false), temp(0)
 #ifdef USE_TILE_WEB
                       , unsent(0), client_rollback(0), send_ignore_one(false)
 #endif
@@ -802,6 +825,7 @@ public:
     {
         prefix_type p = prefix_type::none;
         msgs.push_back(msg);
+        msgs_changed++;
         if (_temporary)
             temp++;
         else
@@ -822,6 +846,7 @@ public:
         unsent = max(0, unsent - temp);
 #endif
         msgs.roll_back(temp);
+        msgs_changed++;
         temp = 0;
     }
 
@@ -864,9 +889,16 @@ public:
         return msgs;
     }
 
-    void append_store(store_t store)
+    // Changes whenever the stored messages do.
+    unsigned int generation() const
+    {
+        return msgs_changed;
+    }
+
+    void append_store(const store_t &store)
     {
         msgs.append(store);
+        msgs_changed++;
         const int msgs_to_print = store.filled_size();
 #ifdef USE_TILE_WEB
         unwind_bool dontsend(send_ignore_one, true);
@@ -878,6 +910,7 @@ public:
     void clear()
     {
         msgs.clear();
+        msgs_changed++;
         prev_msg = message_line();
         last_of_turn = false;
         temp = 0;
@@ -2117,7 +2150,7 @@ string get_last_messages(int mcount, bool full)
     mcount = min(mcount, NUM_STORED_MESSAGES);
     for (int i = -1; mcount > 0; --i)
     {
-        const message_line msg = msgs[i];
+        const message_line &msg = msgs[i];
         if (!msg)
             break;
         if (full || is_channel_dumpworthy(msg.channel))
@@ -2146,7 +2179,7 @@ void get_recent_messages(vector<string> &mess,
     int mcount = NUM_STORED_MESSAGES;
     for (int i = -1; mcount > 0; --i, --mcount)
     {
-        const message_line msg = msgs[i];
+        const message_line &msg = msgs[i];
         if (!msg)
             break;
         mess.push_back(msg.pure_text_with_repeats());
@@ -2164,7 +2197,7 @@ bool recent_error_messages()
     int mcount = NUM_STORED_MESSAGES;
     for (int i = -1; mcount > 0; --i, --mcount)
     {
-        const message_line msg = msgs[i];
+        const message_line &msg = msgs[i];
         if (!msg)
             break;
         if (msg.channel == MSGCH_ERROR)
@@ -2173,21 +2206,46 @@ bool recent_error_messages()
     return false;
 }
 
-// We just write out the whole message store including empty/unused
-// messages. They'll be ignored when restoring.
+// Only the filled part of the store is written, oldest first. Many lines
+// repeat word for word ("You hit the orc."), so each distinct text is written
+// once and the lines refer to it by index.
 void save_messages(writer& outf)
 {
-    store_t msgs = buffer.get_store();
-    marshallInt(outf, msgs.size());
-    for (int i = 0; i < msgs.size(); ++i)
+    const store_t& msgs = buffer.get_store();
+    const int count = msgs.filled_size();
+
+    map<string, int> text_index;
+    vector<const string *> texts;
+    vector<int> line_text(count);
+    for (int i = 0; i < count; ++i)
+    {
+        auto entry = text_index.emplace(msgs[i - count].full_text(),
+                                        (int) texts.size());
+        if (entry.second)
+            texts.push_back(&entry.first->first);
+        line_text[i] = entry.first->second;
+    }
+
+    marshallInt(outf, texts.size());
+    for (const string *text : texts)
+        marshallString4(outf, *text);
+
+    marshallInt(outf, count);
+    for (int i = 0; i < count; ++i)
     {
-        marshallString4(outf, msgs[i].full_text());
-        marshallInt(outf, msgs[i].channel);
-        marshallInt(outf, msgs[i].param);
-        marshallInt(outf, msgs[i].turn);
+        const message_line &msg = msgs[i - count];
+        marshallInt(outf, line_text[i]);
+        marshallInt(outf, msg.channel);
+        marshallInt(outf, msg.param);
+        marshallInt(outf, msg.turn);
     }
 }
 
+unsigned int messages_generation()
+{
+    return buffer.generation();
+}
+
 void load_messages(reader& inf)
 {
     unwind_bool save_more(crawl_state.show_more_prompt, false);
@@ -2197,11 +2255,30 @@ void load_messages(reader& inf)
     store_t load_msgs = buffer.get_store(); // copy of messages during loading
     clear_message_store();
 
+    vector<string> texts;
+#if TAG_MAJOR_VERSION == 34
+    if (inf.getMinorVersion() >= TAG_MINOR_MESSAGE_TABLE)
+#endif
+    {
+        texts.resize(unmarshallInt(inf));
+        for (string &text : texts)
+            unmarshallString4(inf, text);
+    }
+
     int num = unmarshallInt(inf);
     for (int i = 0; i < num; ++i)
     {
         string text;
-        unmarshallString4(inf, text);
+#if TAG_MAJOR_VERSION == 34
+        if (inf.getMinorVersion() < TAG_MINOR_MESSAGE_TABLE)
+            unmarshallString4(inf, text);
+        else
+#endif
+        {
+            const int index = unmarshallInt(inf);
+            ASSERT_RANGE(index, 0, (int) texts.size());
+            text = texts[index];
+        }
 
         msg_channel_type channel = (msg_channel_type) unmarshallInt(inf);
         int           param      = unmarshallInt(inf);
@@ -2224,21 +2301,20 @@ static void _replay_messages_core(formatted_scroller &hist)
 {
     flush_prev_message();
 
-    const store_t msgs = buffer.get_store();
+    // Lines are wrapped once and kept with the message, so this only has to
+    // wrap those added since the history was last shown.
+    const store_t& msgs = buffer.get_store();
+    const int width = cgetsize(GOTO_CRT).x - 1;
     formatted_string lines;
-    for (int i = 0; i < msgs.size(); ++i)
+    for (int i = -msgs.filled_size(); i < 0; ++i)
         if (channel_message_history(msgs[i].channel))
         {
-            string text = msgs[i].full_text();
-            if (!text.size())
-                continue;
-            linebreak_string(text, cgetsize(GOTO_CRT).x - 1);
-            vector<formatted_string> parts;
-            formatted_string::parse_string_to_multiple(text, parts, 80);
+            const vector<formatted_string> &parts
+                = msgs[i].history_lines(width);
             for (unsigned int j = 0; j < parts.size(); ++j)
             {
                 prefix_type p = prefix_type::none;
-                if (j == parts.size() - 1 && i + 1 < msgs.size()
+                if (j == parts.size() - 1 && i + 1 < 0
                     && msgs[i+1].turn > msgs[i].turn)
                 {
                     p = prefix_type::turn_end;
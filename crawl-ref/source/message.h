@@ -140,6 +140,7 @@ void webtiles_send_messages(); // does nothing unless USE_TILE_WEB is defined
 
 void save_messages(writer& outf);
 void load_messages(reader& inf);
+unsigned int messages_generation();
 void clear_message_store();
 
 // Have any messages been printed since the last clear?
@@ -2197,7 +2197,7 @@ static int _tension_door_closed(set<coord_def> door,
 {
     // this unwind is a bit heavy, but because out-of-los clouds dissipate
     // instantly, they can be wiped out by these door tests.
-    unwind_var<map<coord_def, cloud_struct>> cloud_state(env.cloud);
+    unwind_var<grid_map<cloud_struct>> cloud_state(env.cloud);
     _set_door(door, DNGN_CLOSED_DOOR);
     const int new_tension = get_tension(GOD_NO_GOD);
     _set_door(door, old_feat);
@@ -3785,6 +3785,10 @@ static mon_spell_slot _choose_spell_to_cast(monster &mons,
 
     bolt orig_beem = beem;
 
+    // Nothing changes while we choose, so repeated tracers (a spell tried
+    // twice, or an ally checked for several spells) needn't be refired.
+    tracer_cache_scope tracers;
+
     // Promote the casting of useful spells for low-HP monsters.
     // (kraken should always cast their escape spell of inky).
     if (_mons_in_emergency(mons)
@@ -2,6 +2,8 @@
 
 #include "mon-pathfind.h"
 
+#include <algorithm>
+
 #include "directn.h"
 #include "env.h"
 #include "los.h"
@@ -18,16 +20,95 @@
 // The pathfinding is an implementation of the A* algorithm. Beginning at the
 // monster position we check all neighbours of a given grid, estimate the
 // distance needed for any shortest path including this grid and push the
-// result into a hash. We can then easily access all points with the shortest
-// distance estimates and then check _their_ neighbours and so on.
+// result into an open list. We can then easily access all points with the
+// shortest distance estimates and then check _their_ neighbours and so on.
 // The algorithm terminates once we reach the destination since - because
-// of the sorting of grids by shortest distance in the hash - there can be no
+// of the sorting of grids by shortest distance in the list - there can be no
 // path between start and target that is shorter than the current one. There
 // could be other paths that have the same length but that has no real impact.
-// If the hash has been cleared and the start grid has not been encountered,
+// If the list has been emptied and the target grid has not been encountered,
 // then there's no path that matches the requirements fed into monster_pathfind.
 // (These requirements are usually preference of habitat of a specific monster
 // or a limit of the distance between start and any grid on the path.)
+//
+// The open list is a binary heap ordered by total distance estimate, with
+// ties going to the most recently added grid. Grids whose distance improves
+// are pushed again rather than moved; the stale entries are skipped when
+// popped. The distance and backtracking arrays live in a workspace that is
+// reused between searches: a grid's entries are only valid if its stamp
+// matches the workspace's current generation, so nothing needs clearing.
+
+struct pathfind_node
+{
+    int total;
+    unsigned int seq;
+    coord_def pos;
+
+    // Heap order: the top is the lowest total, and the latest added among
+    // equal totals.
+    bool operator<(const pathfind_node &other) const
+    {
+        return total > other.total
+               || (total == other.total && seq < other.seq);
+    }
+};
+
+struct pathfind_workspace
+{
+    unsigned int generation = 0;
+    unsigned int seq = 0;
+    // The generation in which dist and prev were last set for each grid.
+    FixedArray<unsigned int, GXM, GYM> stamp;
+    // The distance from start to any already tried point.
+    FixedArray<int, GXM, GYM> dist;
+    // Where we came from on a given shortest path.
+    FixedArray<int8_t, GXM, GYM> prev;
+    vector<pathfind_node> open;
+
+    pathfind_workspace() : stamp(0) { }
+
+    void reset()
+    {
+        if (++generation == 0)
+        {
+            stamp.init(0);
+            generation = 1;
+        }
+        seq = 0;
+        open.clear();
+    }
+};
+
+// Workspaces not currently in use by a monster_pathfind. They are never
+// freed, so after the first few searches pathfinding doesn't allocate.
+static vector<pathfind_workspace *> free_workspaces;
+
+static pathfind_workspace *_get_workspace()
+{
+    if (free_workspaces.empty())
+        return new pathfind_workspace;
+
+    pathfind_workspace *ws = free_workspaces.back();
+    free_workspaces.pop_back();
+    return ws;
+}
+
+// The last result of cached searches for each monster. The cache only
+// lives for a single turn on a single level, so it can't see terrain or
+// monsters changing between turns.
+struct pathfind_cache_entry
+{
+    mid_t mid;
+    coord_def start, target;
+    int range;
+    bool diag, unmapped;
+    bool found;
+    vector<coord_def> path;
+};
+
+static vector<pathfind_cache_entry> result_cache;
+static int result_cache_turn = -1;
+static level_id result_cache_level;
 
 int mons_tracking_range(const monster* mon)
 {
@@ -62,13 +143,14 @@ int mons_tracking_range(const monster* mon)
 //#define DEBUG_PATHFIND
 monster_pathfind::monster_pathfind()
     : mons(nullptr), start(), target(), pos(), allow_diagonals(true),
-      traverse_unmapped(false), range(0), min_length(0), max_length(0),
-      dist(), prev(), hash()
+      traverse_unmapped(false), traverse_in_sight(false), range(0),
+      ws(_get_workspace()), use_cache(false), from_cache(false)
 {
 }
 
 monster_pathfind::~monster_pathfind()
 {
+    free_workspaces.push_back(ws);
 }
 
 void monster_pathfind::set_range(int r)
@@ -77,9 +159,72 @@ void monster_pathfind::set_range(int r)
         range = r;
 }
 
+/**
+ * Reuse the result of this monster's last search if it was for the same
+ * target during the same turn, and store the result of this search for
+ * later ones. Only useful for monster-based searches.
+ */
+void monster_pathfind::use_result_cache()
+{
+    use_cache = true;
+}
+
 coord_def monster_pathfind::next_pos(const coord_def &c) const
 {
-    return c + Compass[prev[c.x][c.y]];
+    ASSERT(!from_cache);
+    return c + Compass[ws->prev(c)];
+}
+
+bool monster_pathfind::find_cached_result(bool &found)
+{
+    if (result_cache_turn != you.num_turns
+        || result_cache_level != level_id::current())
+    {
+        result_cache.clear();
+        result_cache_turn = you.num_turns;
+        result_cache_level = level_id::current();
+        return false;
+    }
+
+    for (const pathfind_cache_entry &entry : result_cache)
+    {
+        if (entry.mid == mons->mid && entry.start == start
+            && entry.target == target && entry.range == range
+            && entry.diag == allow_diagonals
+            && entry.unmapped == traverse_unmapped)
+        {
+            from_cache = true;
+            found = entry.found;
+            cached_path = entry.path;
+            return true;
+        }
+    }
+    return false;
+}
+
+void monster_pathfind::cache_result(bool found)
+{
+    pathfind_cache_entry *entry = nullptr;
+    for (pathfind_cache_entry &old : result_cache)
+        if (old.mid == mons->mid)
+            entry = &old;
+    if (!entry)
+    {
+        result_cache.emplace_back();
+        entry = &result_cache.back();
+    }
+
+    entry->mid      = mons->mid;
+    entry->start    = start;
+    entry->target   = target;
+    entry->range    = range;
+    entry->diag     = allow_diagonals;
+    entry->unmapped = traverse_unmapped;
+    entry->found    = found;
+    if (found)
+        entry->path = backtrack();
+    else
+        entry->path.clear();
 }
 
 // The main method in the monster_pathfind class.
@@ -107,7 +252,14 @@ bool monster_pathfind::init_pathfind(const monster* mon, coord_def dest,
         return true;
     }
 
-    return start_pathfind(msg);
+    bool found;
+    if (use_cache && find_cached_result(found))
+        return found;
+
+    found = start_pathfind(msg);
+    if (use_cache)
+        cache_result(found);
+    return found;
 }
 
 bool monster_pathfind::init_pathfind(coord_def src, coord_def dest, bool diag,
@@ -134,18 +286,16 @@ bool monster_pathfind::start_pathfind(bool msg)
     //       surrounded by shallow water or floor, or if a foe is hiding in
     //       a wall.
 
-    max_length = min_length = grid_distance(pos, target);
-    for (int i = 0; i < GXM; i++)
-        for (int j = 0; j < GYM; j++)
-            dist[i][j] = INFINITE_DISTANCE;
-
-    dist[pos.x][pos.y] = 0;
+    ws->reset();
+    ws->stamp(pos) = ws->generation;
+    ws->dist(pos) = 0;
 
     bool success = false;
     do
     {
         // Calculate the distance to all neighbours of the current position,
-        // and add them to the hash, if they haven't already been looked at.
+        // and add them to the open list, if they haven't already been looked
+        // at.
         success = calc_path_to_neighbours();
         if (success)
             return true;
@@ -209,8 +359,8 @@ bool monster_pathfind::calc_path_to_neighbours()
         if (range && estimated_cost(npos) > range)
             continue;
 
-        distance = dist[pos.x][pos.y] + travel_cost(npos);
-        old_dist = dist[npos.x][npos.y];
+        distance = ws->dist(pos) + travel_cost(npos);
+        old_dist = distance_to(npos);
 
         // Also bail out if this would make the path longer than twice the
         // allowed distance from the target. (This factor may need tuning.)
@@ -231,28 +381,18 @@ bool monster_pathfind::calc_path_to_neighbours()
         {
             // Calculate new total path length.
             total = distance + estimated_cost(npos);
-            if (old_dist == INFINITE_DISTANCE)
-            {
 #ifdef DEBUG_PATHFIND
-                mprf("Adding (%d,%d) to hash (total dist = %d)",
-                     npos.x, npos.y, total);
+            mprf("%s (%d,%d) with total dist %d",
+                 old_dist == INFINITE_DISTANCE ? "Adding" : "Improving",
+                 npos.x, npos.y, total);
 #endif
-                add_new_pos(npos, total);
-                if (total > max_length)
-                    max_length = total;
-            }
-            else
-            {
-#ifdef DEBUG_PATHFIND
-                mprf("Improving (%d,%d) to total dist %d",
-                     npos.x, npos.y, total);
-#endif
-
-                update_pos(npos, total);
-            }
+            // Any entry for the old distance is left in the open list,
+            // and skipped once it comes up.
+            add_new_pos(npos, total);
 
             // Update distance start->pos.
-            dist[npos.x][npos.y] = distance;
+            ws->stamp(npos) = ws->generation;
+            ws->dist(npos) = distance;
 
             // Set backtracking information.
             // Converts the Compass direction to its counterpart.
@@ -260,7 +400,7 @@ bool monster_pathfind::calc_path_to_neighbours()
             //      7  .  3   ==>   3  .  7       e.g. (3 + 4) % 8          = 7
             //      6  5  4         2  1  0            (7 + 4) % 8 = 11 % 8 = 3
 
-            prev[npos.x][npos.y] = (dir + 4) % 8;
+            ws->prev(npos) = (dir + 4) % 8;
 
             // Are we finished?
             if (npos == target)
@@ -275,34 +415,26 @@ bool monster_pathfind::calc_path_to_neighbours()
     return false;
 }
 
-// Starting at known min_length (minimum total estimated path distance), check
-// the hash for existing vectors, then pick the last entry of the first vector
-// that matches. Update min_length, if necessary.
+// Pop the position with the shortest total distance estimate off the open
+// list, skipping entries that have since been improved on.
 bool monster_pathfind::get_best_position()
 {
-    for (int i = min_length; i <= max_length; i++)
+    vector<pathfind_node> &open = ws->open;
+    while (!open.empty())
     {
-        if (!hash[i].empty())
-        {
-            if (i > min_length)
-                min_length = i;
+        pop_heap(open.begin(), open.end());
+        const pathfind_node best = open.back();
+        open.pop_back();
 
-            vector<coord_def> &vec = hash[i];
-            // Pick the last position pushed into the vector as it's most
-            // likely to be close to the target.
-            pos = vec[vec.size()-1];
-            vec.pop_back();
+        if (best.total != distance_to(best.pos) + estimated_cost(best.pos))
+            continue;
 
+        pos = best.pos;
 #ifdef DEBUG_PATHFIND
-            mprf("Returning (%d, %d) as best pos with total dist %d.",
-                 pos.x, pos.y, min_length);
-#endif
-
-            return true;
-        }
-#ifdef DEBUG_PATHFIND
-        mprf("No positions for path length %d.", i);
+        mprf("Returning (%d, %d) as best pos with total dist %d.",
+             pos.x, pos.y, best.total);
 #endif
+        return true;
     }
 
     // Nothing found? Then there's no path! :(
@@ -316,6 +448,9 @@ vector<coord_def> monster_pathfind::backtrack()
 #ifdef DEBUG_PATHFIND
     mpr("Backtracking...");
 #endif
+    if (from_cache)
+        return cached_path;
+
     vector<coord_def> path;
     pos = target;
     path.push_back(pos);
@@ -326,7 +461,7 @@ vector<coord_def> monster_pathfind::backtrack()
     int dir;
     do
     {
-        dir = prev[pos.x][pos.y];
+        dir = ws->prev(pos);
         pos = pos + Compass[dir];
         ASSERT_IN_BOUNDS(pos);
 #ifdef DEBUG_PATHFIND
@@ -489,26 +624,14 @@ int monster_pathfind::estimated_cost(coord_def p)
     return grid_distance(p, target);
 }
 
-void monster_pathfind::add_new_pos(coord_def npos, int total)
+// The distance from start to p found so far.
+int monster_pathfind::distance_to(const coord_def& p) const
 {
-    hash[total].push_back(npos);
+    return ws->stamp(p) == ws->generation ? ws->dist(p) : INFINITE_DISTANCE;
 }
 
-void monster_pathfind::update_pos(coord_def npos, int total)
+void monster_pathfind::add_new_pos(coord_def npos, int total)
 {
-    // Find hash position of old distance and delete it,
-    // then call_add_new_pos.
-    int old_total = dist[npos.x][npos.y] + estimated_cost(npos);
-
-    vector<coord_def> &vec = hash[old_total];
-    for (unsigned int i = 0; i < vec.size(); i++)
-    {
-        if (vec[i] == npos)
-        {
-            vec.erase(vec.begin() + i);
-            break;
-        }
-    }
-
-    add_new_pos(npos, total);
+    ws->open.push_back({ total, ws->seq++, npos });
+    push_heap(ws->open.begin(), ws->open.end());
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 class monster;
+struct pathfind_workspace;
 
 int mons_tracking_range(const monster* mon);
 
@@ -9,9 +10,11 @@ class monster_pathfind
 public:
     monster_pathfind();
     virtual ~monster_pathfind();
+    DISALLOW_COPY_AND_ASSIGN(monster_pathfind);
 
     // public methods
     void set_range(int r);
+    void use_result_cache();
     coord_def next_pos(const coord_def &p) const;
     bool init_pathfind(const monster* mon, coord_def dest,
                        bool diag = true, bool msg = false,
@@ -30,9 +33,11 @@ protected:
     bool mons_traversable(const coord_def& p);
     int  mons_travel_cost(coord_def npos);
     int  estimated_cost(coord_def npos);
+    int  distance_to(const coord_def& p) const;
     void add_new_pos(coord_def pos, int total);
-    void update_pos(coord_def pos, int total);
     bool get_best_position();
+    bool find_cached_result(bool &found);
+    void cache_result(bool found);
 
     // The monster trying to find a path.
     const monster* mons;
@@ -55,14 +60,13 @@ protected:
     // Maximum range to search between start and target. None, if zero.
     int range;
 
-    // Currently shortest and longest possible total length of the path.
-    int min_length;
-    int max_length;
+    // Distances, backtracking information and the open list, borrowed
+    // from a pool for the lifetime of this object.
+    pathfind_workspace *ws;
 
-    // The array of distances from start to any already tried point.
-    int dist[GXM][GYM];
-    // An array to store where we came from on a given shortest path.
-    int prev[GXM][GYM];
-
-    FixedVector<vector<coord_def>, GXM * GYM> hash;
+    // If true, look up and store the result in the per-monster cache.
+    bool use_cache;
+    // If true, the path came from the cache rather than the workspace.
+    bool from_cache;
+    vector<coord_def> cached_path;
 };
@@ -853,6 +853,7 @@ monster* get_free_monster()
         if (mons.type == MONS_NO_MONSTER)
         {
             mons.reset();
+            mons.update_slot_index(true);
             return &mons;
         }
 
@@ -162,6 +162,32 @@ void monster::reset()
     // Just for completeness.
     speed           = 0;
     colour         = COLOUR_INHERIT;
+
+    update_slot_index(false);
+}
+
+/**
+ * Keep env.mons_used up to date with this monster's slot, if it has one.
+ *
+ * @param in_use Whether the slot may now hold a monster.
+ */
+void monster::update_slot_index(bool in_use)
+{
+    // Followers in transit, stack dummies and other copies live outside
+    // env.mons, and taking mindex() of them would be meaningless.
+    const monster *first = menv.buffer();
+    const less<const monster *> before;
+    if (before(this, first) || !before(this, first + MAX_MONSTERS))
+        return;
+    const int idx = this - first;
+
+    vector<int> &used = env.mons_used;
+    auto it = lower_bound(used.begin(), used.end(), idx);
+    const bool listed = it != used.end() && *it == idx;
+    if (in_use && !listed)
+        used.insert(it, idx);
+    else if (!in_use && listed)
+        used.erase(it);
 }
 
 void monster::init_with(const monster& mon)
@@ -206,6 +232,8 @@ void monster::init_with(const monster& mon)
         ghost.reset(new ghost_demon(*mon.ghost));
     else
         ghost.reset(nullptr);
+
+    update_slot_index(type != MONS_NO_MONSTER);
 }
 
 uint32_t monster::last_client_id = 0;
@@ -48,6 +48,7 @@ public:
 
     monster& operator = (const monster& other);
     void reset();
+    void update_slot_index(bool in_use);
 
 public:
     // Possibly some of these should be moved into the hash table
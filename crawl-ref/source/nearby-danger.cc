@@ -83,6 +83,9 @@ static bool _mons_has_path_to_player(const monster* mon, bool want_move = false)
     // track you that far out-of-sight. Use a factor of 2 for smarter
     // creatures as a safety margin.
     mp.set_range(max(LOS_RADIUS, range * 2));
+    // This gets asked repeatedly for each visible monster while the player
+    // decides what to do, so reuse the answer within a turn.
+    mp.use_result_cache();
 
     if (mp.init_pathfind(mon, you.pos(), true, false, true))
         return true;
@@ -477,6 +477,7 @@ void Note::load(reader& inf)
 }
 
 static bool notes_active = false;
+static unsigned int notes_changed = 0;
 
 bool notes_are_active()
 {
@@ -488,6 +489,7 @@ void take_note(const Note& note, bool force)
     if (notes_active && (force || _is_noteworthy(note)))
     {
         note_list.push_back(note);
+        notes_changed++;
         note.check_milestone();
     }
 }
@@ -505,8 +507,21 @@ void save_notes(writer& outf)
         note.save(outf);
 }
 
+// Changes whenever a note is added, so saving can tell if it's needed.
+unsigned int notes_generation()
+{
+    return notes_changed;
+}
+
+void clear_notes()
+{
+    note_list.clear();
+    notes_changed++;
+}
+
 void load_notes(reader& inf)
 {
+    notes_changed++;
     if (unmarshallInt(inf) != NOTES_VERSION_NUMBER)
         return;
 
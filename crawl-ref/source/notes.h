@@ -92,6 +92,8 @@ void activate_notes(bool active);
 bool notes_are_active();
 void take_note(const Note& note, bool force = false);
 void save_notes(writer&);
+unsigned int notes_generation();
+void clear_notes();
 void load_notes(reader&);
 void make_user_note();
 
@@ -163,6 +163,9 @@ public:
     map<string, cglyph_t> item_glyph_cache;
 
     string      save_dir;       // Directory where saves and bones go.
+    bool        async_save;     // Write saves in the background.
+    string      save_compression;       // Codec and level for new chunks.
+    string      save_compression_dict;  // zstd dictionary for level chunks.
     string      macro_dir;      // Directory containing macro.txt
     string      morgue_dir;     // Directory where character dumps and morgue
                                 // dumps are saved. Overrides crawl_dir.
@@ -175,6 +178,7 @@ public:
     uint64_t    seed_from_rc;
     bool        pregen_dungeon; // Is the dungeon completely generated at the beginning?
     bool        incremental_pregen; // Does the dungeon always generate in a specified order?
+    bool        background_pregen; // Are remaining levels generated while idle?
 
 #ifdef DGL_SIMPLE_MESSAGING
     bool        messaging;      // Check for messages.
@@ -16,6 +16,10 @@ Notes:
 * Readers always get the last complete (but not necessarily committed) write
   (ie, READ_UNCOMMITTED) at the time they started; it is safe to continue
   reading even if the chunk has been changed since.
+* With asynchronous saving, queued writes and commits are carried out by the
+  background thread in the order they were queued, so a commit covers
+  exactly the writes queued before it, and is only made once their data is
+  on disk.
 */
 
 #include "AppHdr.h"
@@ -25,6 +29,7 @@ Notes:
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <sstream>
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -37,7 +42,11 @@ Notes:
 #include "endianness.h"
 #include "errors.h"
 #include "syscalls.h"
-#include "libutil.h" // map_find
+#include "libutil.h" // map_find, parse_int
+#include "stringutil.h"
+#ifdef ASYNC_SAVES
+#include "threads.h"
+#endif
 
 // debugging defines
 #undef  FSCK_VERBOSE
@@ -59,9 +68,17 @@ static plen_t htole(plen_t x)
 #define dprintf(...) do {} while (0)
 #endif
 
-#define PACKAGE_VERSION 1
+// Version 2 is version 1 with chunks in codecs other than zlib, which
+// older versions would misread; saves without such chunks stay at 1.
+#define PACKAGE_VERSION 2
 #define PACKAGE_MAGIC   0x53534344 /* "DCSS" */
 
+// Chunks in codecs other than zlib start with a tag byte that can't begin
+// a zlib stream (deflate streams have 8 in the low nibble), so zlib chunks
+// need none. The zstd tag is followed by the dictionary id, or 0.
+#define ZSTD_CHUNK_TAG  0x5a /* 'Z' */
+#define ZSTD_TAG_LEN    5
+
 struct file_header
 {
     uint32_t magic;
@@ -81,8 +98,234 @@ typedef pair<plen_t, plen_t> bm_p;
 typedef map<plen_t, bm_p> bm_t;
 typedef map<plen_t, plen_t> fb_t;
 
+// A chunk write or (with an empty name) a commit, queued for the background
+// writer.
+struct async_job
+{
+    string name;
+    vector<unsigned char> data;
+    bool use_dict = false;
+};
+
+struct package_async
+{
+#ifdef ASYNC_SAVES
+    // Guards everything here, and all of the package's state while the
+    // writer thread runs.
+    mutex_t lock;
+    cond_t work;    // a job has been queued, or the writer should stop
+    cond_t idle;    // a job has been finished
+    thread_t thread;
+#endif
+    deque<async_job> queue;
+    map<string, int> pending;   // queued or in-progress writes, by name
+    bool busy = false;
+    bool stop = false;
+    string error;               // the failure that stopped the writer
+};
+
+#ifdef ASYNC_SAVES
+static thread_local bool in_save_writer = false;
+#endif
+
+#ifdef USE_ZSTD
+struct save_dictionary
+{
+    string file;
+    vector<char> data;
+    ZSTD_DDict *ddict;
+};
+
+// Never freed: readers may hold on to them.
+static map<uint32_t, save_dictionary> save_dictionaries;
+#endif
+
+bool save_codec_available(save_codec codec)
+{
+    switch (codec)
+    {
+    case SAVE_CODEC_ZLIB:
+        return true;
+    case SAVE_CODEC_ZSTD:
+#ifdef USE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * Parse a compression setting of the form "<codec>[:<level>]", such as
+ * "zlib" or "zstd:19".
+ *
+ * @param spec  The setting.
+ * @param comp  Gets the codec and level; the dictionary is left alone.
+ * @param error What's wrong with the setting, if it can't be used.
+ * @return Whether the setting is valid, and the codec is available.
+ */
+bool parse_save_compression(const string &spec, save_compression &comp,
+                            string &error)
+{
+    const size_t colon = spec.find(':');
+    const string name = spec.substr(0, colon);
+    int level = 0;
+    int max_level;
+
+    save_compression res = comp;
+    if (name == "zlib")
+    {
+        res.codec = SAVE_CODEC_ZLIB;
+        max_level = 9;
+    }
+    else if (name == "zstd")
+    {
+        res.codec = SAVE_CODEC_ZSTD;
+#ifdef USE_ZSTD
+        max_level = ZSTD_maxCLevel();
+#else
+        max_level = 22;
+#endif
+    }
+    else
+    {
+        error = make_stringf("unknown save compression \"%s\"", name.c_str());
+        return false;
+    }
+
+    if (colon != string::npos
+        && (!parse_int(spec.substr(colon + 1).c_str(), level)
+            || level < 1 || level > max_level))
+    {
+        error = make_stringf("%s compression level must be 1 to %d",
+                             name.c_str(), max_level);
+        return false;
+    }
+
+    if (!save_codec_available(res.codec))
+    {
+        error = make_stringf("this build doesn't support %s compression",
+                             name.c_str());
+        return false;
+    }
+
+    res.level = level;
+    comp = res;
+    return true;
+}
+
+/**
+ * Load a zstd dictionary, as trained by "zstd --train", for use with
+ * save_compression. Loading the same file again is cheap.
+ *
+ * @param file The dictionary file.
+ * @return The dictionary's id, which is recorded in chunks using it.
+ */
+uint32_t load_save_dictionary(const string &file)
+{
+#ifdef USE_ZSTD
+    for (const auto &entry : save_dictionaries)
+        if (entry.second.file == file)
+            return entry.first;
+
+    FILE *f = fopen_u(file.c_str(), "rb");
+    if (!f)
+        sysfail("can't open compression dictionary %s", file.c_str());
+    vector<char> data;
+    char buf[16384];
+    while (size_t len = fread(buf, 1, sizeof(buf), f))
+        data.insert(data.end(), buf, buf + len);
+    const bool error = ferror(f);
+    fclose(f);
+    if (error)
+        fail("error reading compression dictionary %s", file.c_str());
+
+    const uint32_t id = ZSTD_getDictID_fromDict(data.data(), data.size());
+    if (!id)
+        fail("%s is not a zstd dictionary", file.c_str());
+    if (save_dictionaries.count(id))
+        return id;
+
+    save_dictionary &dict = save_dictionaries[id];
+    dict.file = file;
+    dict.data = move(data);
+    dict.ddict = ZSTD_createDDict(dict.data.data(), dict.data.size());
+    if (!dict.ddict)
+        fail("can't load compression dictionary %s", file.c_str());
+    return id;
+#else
+    fail("can't load compression dictionary %s: this build doesn't support "
+         "zstd compression", file.c_str());
+#endif
+}
+
+#ifdef USE_ZSTD
+static ZSTD_CCtx *_zstd_cctx(const save_compression &comp, bool use_dict,
+                             uint32_t &dict_id)
+{
+    ZSTD_CCtx *zc = ZSTD_createCCtx();
+    if (!zc)
+        fail("save file compression failed during init");
+    ZSTD_CCtx_setParameter(zc, ZSTD_c_compressionLevel,
+                           comp.level ? comp.level : ZSTD_CLEVEL_DEFAULT);
+
+    dict_id = 0;
+    if (use_dict && comp.dict)
+    {
+        const save_dictionary &dict = save_dictionaries.at(comp.dict);
+        const size_t res = ZSTD_CCtx_loadDictionary(zc, dict.data.data(),
+                                                    dict.data.size());
+        if (ZSTD_isError(res))
+        {
+            ZSTD_freeCCtx(zc);
+            fail("save file compression failed during init: %s",
+                 ZSTD_getErrorName(res));
+        }
+        dict_id = comp.dict;
+    }
+    return zc;
+}
+
+static void _zstd_tag(unsigned char *tag, uint32_t dict_id)
+{
+    tag[0] = ZSTD_CHUNK_TAG;
+    dict_id = htole32(dict_id);
+    memcpy(tag + 1, &dict_id, sizeof(dict_id));
+}
+#endif
+
+static save_codec _chunk_codec(const vector<unsigned char> &data)
+{
+    return !data.empty() && data[0] == ZSTD_CHUNK_TAG ? SAVE_CODEC_ZSTD
+                                                      : SAVE_CODEC_ZLIB;
+}
+
+// Holds the background writer's lock, if there is a writer, while in scope.
+class package_guard
+{
+public:
+    package_guard(package_async *_bg) : bg(_bg)
+    {
+#ifdef ASYNC_SAVES
+        if (bg)
+            mutex_lock(bg->lock);
+#endif
+    }
+    ~package_guard()
+    {
+#ifdef ASYNC_SAVES
+        if (bg)
+            mutex_unlock(bg->lock);
+#endif
+    }
+private:
+    package_async *bg;
+};
+
 package::package(const char* file, bool writeable, bool empty)
-  : n_users(0), dirty(false), aborted(false)
+  : n_users(0), dirty(false), aborted(false), bg(nullptr)
 #ifdef DO_FSYNC
     , tmp(false)
 #endif
@@ -132,7 +375,7 @@ package::package(const char* file, bool writeable, bool empty)
 }
 
 package::package()
-  : rw(true), n_users(0), dirty(false), aborted(false)
+  : rw(true), n_users(0), dirty(false), aborted(false), bg(nullptr)
 #ifdef DO_FSYNC
     , tmp(true)
 #endif
@@ -182,6 +425,12 @@ void package::load()
     file_len = len;
     read_directory(htole(head.start), head.version);
 
+    // Which chunks use other codecs isn't recorded; assume any might, until
+    // they are rewritten.
+    if (head.version >= 2)
+        for (const auto &entry : directory)
+            zstd_chunks.insert(entry.first);
+
     if (rw)
         load_traces();
 }
@@ -208,6 +457,7 @@ void package::load_traces()
 package::~package()
 {
     dprintf("package: finalizing\n");
+    stop_async();
     ASSERT(!n_users || CrawlIsCrashing); // not merely aborted, there are
         // live pointers to us. With normal stack unwinding, destructors
         // will make sure this never happens and this assert is good for
@@ -234,32 +484,59 @@ package::~package()
 void package::commit()
 {
     ASSERT(rw);
-    if (!dirty)
-        return;
     ASSERT(!aborted);
 
-#ifdef COSTLY_ASSERTS
-    fsck();
+    if (bg)
+    {
+        package_guard g(bg);
+        bg->queue.emplace_back();
+#ifdef ASYNC_SAVES
+        cond_wake(bg->work);
 #endif
+        return;
+    }
+
+    commit_now();
+}
 
+// The state is only locked around the parts that touch it: the syncs can
+// take a while, and reads can safely go on meanwhile.
+void package::commit_now()
+{
     file_header head;
-    head.magic = htole(PACKAGE_MAGIC);
-    head.version = PACKAGE_VERSION;
-    memset(&head.padding, 0, sizeof(head.padding));
-    head.start = htole(write_directory());
+    {
+        package_guard g(bg);
+        if (!dirty || aborted)
+            return;
+
+#ifdef COSTLY_ASSERTS
+        fsck();
+#endif
+
+        head.magic = htole(PACKAGE_MAGIC);
+        memset(&head.padding, 0, sizeof(head.padding));
+        head.start = htole(write_directory());
+        head.version = zstd_chunks.empty() ? 1 : PACKAGE_VERSION;
+    }
 #ifdef DO_FSYNC
     // We need a barrier before updating the link to point at the new directory.
     if (!tmp && fdatasync(fd))
         sysfail("flush error while saving");
 #endif
-    seek(0);
-    if (write(fd, &head, sizeof(head)) != sizeof(head))
-        sysfail("write error while saving");
+    {
+        package_guard g(bg);
+        if (aborted)
+            return;
+        seek(0);
+        if (write(fd, &head, sizeof(head)) != sizeof(head))
+            sysfail("write error while saving");
+    }
 #ifdef DO_FSYNC
     if (!tmp && fdatasync(fd))
         sysfail("flush error while saving");
 #endif
 
+    package_guard g(bg);
     new_chunks.clear();
     collect_blocks();
     dirty = false;
@@ -269,6 +546,279 @@ void package::commit()
 #endif
 }
 
+// Compress a whole chunk into its on-disk format.
+void package::compress_chunk(const vector<unsigned char> &in,
+                             vector<unsigned char> &out, bool use_dict)
+{
+#ifdef USE_ZSTD
+    if (compression.codec == SAVE_CODEC_ZSTD)
+    {
+        uint32_t dict_id;
+        ZSTD_CCtx *zc = _zstd_cctx(compression, use_dict, dict_id);
+        out.resize(ZSTD_TAG_LEN + ZSTD_compressBound(in.size()));
+        _zstd_tag(out.data(), dict_id);
+        const size_t len = ZSTD_compress2(zc, &out[ZSTD_TAG_LEN],
+                                          out.size() - ZSTD_TAG_LEN,
+                                          in.data(), in.size());
+        ZSTD_freeCCtx(zc);
+        if (ZSTD_isError(len))
+            fail("save file compression failed: %s", ZSTD_getErrorName(len));
+        out.resize(ZSTD_TAG_LEN + len);
+        return;
+    }
+#else
+    UNUSED(use_dict);
+#endif
+#ifdef USE_ZLIB
+    uLongf len = compressBound(in.size());
+    out.resize(len);
+    if (compress2(out.data(), &len, in.data(), in.size(),
+                  compression.level ? compression.level
+                                    : Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        fail("save file compression failed");
+    }
+    out.resize(len);
+#else
+    out = in;
+#endif
+}
+
+void package::write_precompressed(const string &name,
+                                  const vector<unsigned char> &data)
+{
+    package_guard g(bg);
+    if (aborted)
+        return;
+    chunk_writer cw(this, name, false, true);
+    cw.codec = _chunk_codec(data);
+    cw.raw_write(data.data(), data.size());
+}
+
+/**
+ * Set how chunks written from now on are compressed. Chunks already
+ * written stay as they are, and remain readable.
+ */
+void package::set_compression(const save_compression &comp)
+{
+    ASSERT(save_codec_available(comp.codec));
+    // The background writer may be compressing with the old settings.
+    flush();
+    package_guard g(bg);
+    compression = comp;
+}
+
+/**
+ * Write a whole chunk at once: in the background if asynchronous saving
+ * has been started, otherwise right away.
+ *
+ * @param name     The chunk's name.
+ * @param data     The chunk's contents, uncompressed.
+ * @param use_dict Whether to compress with the dictionary, if any.
+ */
+void package::write_chunk(const string &name, vector<unsigned char> data,
+                          bool use_dict)
+{
+    ASSERT(!aborted);
+
+    if (!bg)
+    {
+        chunk_writer cw(this, name, use_dict);
+        if (!data.empty())
+            cw.write(data.data(), data.size());
+        return;
+    }
+
+    package_guard g(bg);
+    bg->queue.emplace_back();
+    bg->queue.back().name = name;
+    bg->queue.back().data = move(data);
+    bg->queue.back().use_dict = use_dict;
+    bg->pending[name]++;
+#ifdef ASYNC_SAVES
+    cond_wake(bg->work);
+#endif
+}
+
+void *package::async_main(void *arg)
+{
+#ifdef ASYNC_SAVES
+    package *pkg = static_cast<package *>(arg);
+    package_async *bg = pkg->bg;
+    in_save_writer = true;
+
+    mutex_lock(bg->lock);
+    while (true)
+    {
+        while (bg->queue.empty() && !bg->stop)
+            cond_wait(bg->work, bg->lock);
+        if (bg->queue.empty())
+            break;
+
+        async_job job = move(bg->queue.front());
+        bg->queue.pop_front();
+        bg->busy = true;
+
+        // After a failure the rest of the queue is dropped; in particular
+        // nothing more is committed.
+        if (bg->error.empty() && !pkg->aborted)
+        {
+            mutex_unlock(bg->lock);
+            string error;
+            try
+            {
+                if (job.name.empty())
+                    pkg->commit_now();
+                else
+                {
+                    vector<unsigned char> z;
+                    pkg->compress_chunk(job.data, z, job.use_dict);
+                    pkg->write_precompressed(job.name, z);
+                }
+            }
+            catch (ext_fail_exception &fe)
+            {
+                error = fe.what();
+            }
+            mutex_lock(bg->lock);
+            if (!error.empty())
+                bg->error = error;
+        }
+
+        if (!job.name.empty() && !--bg->pending[job.name])
+            bg->pending.erase(job.name);
+        bg->busy = false;
+        cond_wake(bg->idle);
+    }
+    mutex_unlock(bg->lock);
+#else
+    UNUSED(arg);
+#endif
+    return nullptr;
+}
+
+/**
+ * Start a background thread to compress and write out chunks given to
+ * write_chunk(), and to make commits. Does nothing if the thread is
+ * already running or the platform doesn't support it.
+ */
+void package::start_async()
+{
+#ifdef ASYNC_SAVES
+    if (bg || !rw || aborted)
+        return;
+
+    bg = new package_async;
+    mutex_init(bg->lock);
+    cond_init(bg->work);
+    cond_init(bg->idle);
+    if (thread_create_joinable(&bg->thread, async_main, this))
+    {
+        cond_destroy(bg->idle);
+        cond_destroy(bg->work);
+        mutex_destroy(bg->lock);
+        delete bg;
+        bg = nullptr;
+    }
+#endif
+}
+
+/**
+ * Wait until everything queued for the background writer has been
+ * written.
+ *
+ * @throws ext_fail_exception if the writer has failed.
+ */
+void package::flush()
+{
+#ifdef ASYNC_SAVES
+    // The writer itself can get here through a fatal error.
+    if (!bg || in_save_writer)
+        return;
+
+    string error;
+    {
+        package_guard g(bg);
+        while (!bg->queue.empty() || bg->busy)
+            cond_wait(bg->idle, bg->lock);
+        error = bg->error;
+    }
+    if (!error.empty())
+        fail("%s", error.c_str());
+#endif
+}
+
+/**
+ * Finish everything queued for the background writer and stop it, going
+ * back to writing synchronously. Safe to call at exit: failures have
+ * already been reported, and won't be again.
+ */
+void package::stop_async()
+{
+#ifdef ASYNC_SAVES
+    if (!bg || in_save_writer)
+        return;
+
+    {
+        package_guard g(bg);
+        bg->stop = true;
+        cond_wake(bg->work);
+    }
+    thread_join(bg->thread);
+
+    cond_destroy(bg->idle);
+    cond_destroy(bg->work);
+    mutex_destroy(bg->lock);
+    delete bg;
+    bg = nullptr;
+#endif
+}
+
+/**
+ * On a crash, give the background writer a bounded time to finish the
+ * writes and commits already queued, then drop whatever is left so that
+ * nothing more is committed. Unlike stop_async() this can't hang: the crash
+ * may have happened on the writer thread, or with the package locked.
+ *
+ * What survives is the save as of the last commit the writer finished.
+ * Writes queued after that commit, and anything not reached in time, are
+ * lost, as unsaved progress always is on a crash. The save on disk is
+ * valid either way, since the directory is only written after its data.
+ *
+ * @param timeout_ms How long to wait for the writer.
+ * @return whether everything queued was written.
+ */
+bool package::drain_async_for_crash(int timeout_ms)
+{
+#ifdef ASYNC_SAVES
+    if (!bg)
+        return true;
+    // The writer itself crashed, so nothing more will be written.
+    if (in_save_writer)
+        return false;
+
+    bool drained = false;
+    for (int waited = 0; ; waited += 10)
+    {
+        {
+            package_guard g(bg);
+            drained = bg->queue.empty() && !bg->busy && bg->error.empty();
+            if (drained || waited >= timeout_ms || !bg->error.empty())
+            {
+                bg->queue.clear();
+                bg->pending.clear();
+                break;
+            }
+        }
+        usleep(10 * 1000);
+    }
+    return drained;
+#else
+    UNUSED(timeout_ms);
+    return true;
+#endif
+}
+
 void package::seek(plen_t to)
 {
     ASSERT(!aborted);
@@ -279,13 +829,32 @@ void package::seek(plen_t to)
         sysfail("failed to seek inside the save file");
 }
 
-chunk_writer* package::writer(const string &name)
+chunk_writer* package::writer(const string &name, bool use_dict)
 {
-    return new chunk_writer(this, name);
+    flush();
+    return new chunk_writer(this, name, use_dict);
+}
+
+// Wait for any queued writes of the named chunk.
+void package::flush_chunk(const string &name)
+{
+    if (!bg)
+        return;
+
+    bool queued;
+    {
+        package_guard g(bg);
+        queued = bg->pending.count(name);
+    }
+    if (queued)
+        flush();
 }
 
 chunk_reader* package::reader(const string &name)
 {
+    flush_chunk(name);
+
+    package_guard g(bg);
     if (plen_t *ch = map_find(directory, name))
         return new chunk_reader(this, *ch);
     return 0;
@@ -359,10 +928,14 @@ plen_t package::alloc_block(plen_t &size)
     return at;
 }
 
-void package::finish_chunk(const string &name, plen_t at)
+void package::finish_chunk(const string &name, plen_t at, save_codec codec)
 {
     free_chunk(name);
     directory[name] = at;
+    if (codec == SAVE_CODEC_ZLIB)
+        zstd_chunks.erase(name);
+    else
+        zstd_chunks.insert(name);
     new_chunks.insert(at);
     dirty = true;
 }
@@ -384,8 +957,11 @@ void package::free_chunk(const string &name)
 
 void package::delete_chunk(const string &name)
 {
+    flush();
+    package_guard g(bg);
     free_chunk(name);
     directory.erase(name);
+    zstd_chunks.erase(name);
 }
 
 plen_t package::write_directory()
@@ -540,6 +1116,7 @@ void package::read_directory(plen_t start, uint8_t version)
         }
         break;
     case 1:
+    case 2:
         uint8_t name_len;
         plen_t bstart;
         while (plen_t res = rd.read(&name_len, sizeof(name_len)))
@@ -564,11 +1141,16 @@ void package::read_directory(plen_t start, uint8_t version)
 
 bool package::has_chunk(const string &name)
 {
-    return !name.empty() && directory.count(name);
+    if (name.empty())
+        return false;
+
+    package_guard g(bg);
+    return directory.count(name) || (bg && bg->pending.count(name));
 }
 
 vector<string> package::list_chunks()
 {
+    flush();
     vector<string> list;
     list.reserve(directory.size());
     for (const auto &entry : directory)
@@ -619,7 +1201,20 @@ void package::abort()
     // Disable any further operations, allow a shutdown. All errors past
     // this point are ignored (assuming we already failed). All writes since
     // the last commit() are lost.
+    package_guard g(bg);
     aborted = true;
+
+#ifdef ASYNC_SAVES
+    // Drop anything queued, but let a write in progress finish before the
+    // file can be closed under it.
+    if (bg && !in_save_writer)
+    {
+        bg->queue.clear();
+        bg->pending.clear();
+        while (bg->busy)
+            cond_wait(bg->idle, bg->lock);
+    }
+#endif
 }
 
 void package::unlink()
@@ -633,6 +1228,7 @@ void package::unlink()
 // the amount of free space not at the end of file
 plen_t package::get_slack()
 {
+    flush();
     load_traces();
 
     plen_t slack = 0;
@@ -643,6 +1239,7 @@ plen_t package::get_slack()
 
 plen_t package::get_chunk_fragmentation(const string &name)
 {
+    flush();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t frags = 0;
@@ -659,6 +1256,7 @@ plen_t package::get_chunk_fragmentation(const string &name)
 
 plen_t package::get_chunk_compressed_length(const string &name)
 {
+    flush();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t len = 0;
@@ -673,8 +1271,10 @@ plen_t package::get_chunk_compressed_length(const string &name)
     return len;
 }
 
-chunk_writer::chunk_writer(package *parent, const string &_name)
-    : first_block(0), cur_block(0), block_len(0)
+chunk_writer::chunk_writer(package *parent, const string &_name,
+                           bool use_dict, bool _precompressed)
+    : first_block(0), cur_block(0), block_len(0),
+      precompressed(_precompressed), codec(parent->compression.codec)
 {
     ASSERT(parent);
     ASSERT(!parent->aborted);
@@ -689,15 +1289,37 @@ chunk_writer::chunk_writer(package *parent, const string &_name)
     name = _name;
 
 #ifdef USE_ZLIB
+    if (precompressed)
+        return;
+
+#define ZB_SIZE 32768
+#ifdef USE_ZSTD
+    zc = nullptr;
+    if (codec == SAVE_CODEC_ZSTD)
+    {
+        uint32_t dict_id;
+        zc = _zstd_cctx(pkg->compression, use_dict, dict_id);
+        unsigned char tag[ZSTD_TAG_LEN];
+        _zstd_tag(tag, dict_id);
+        raw_write(tag, sizeof(tag));
+        z_buffer = (Bytef*)malloc(ZB_SIZE);
+        return;
+    }
+#else
+    UNUSED(use_dict);
+#endif
+
+    const int level = pkg->compression.level;
     zs.data_type = Z_BINARY;
     zs.zalloc    = 0;
     zs.zfree     = 0;
     zs.opaque    = Z_NULL;
-    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION))
+    if (deflateInit(&zs, level ? level : Z_DEFAULT_COMPRESSION))
         fail("save file compression failed during init: %s", zs.msg);
-#define ZB_SIZE 32768
     zs.next_out  = z_buffer = (Bytef*)malloc(ZB_SIZE);
     zs.avail_out = ZB_SIZE;
+#else
+    UNUSED(use_dict);
 #endif
 }
 
@@ -710,14 +1332,56 @@ chunk_writer::~chunk_writer()
     if (pkg->aborted)
     {
 #ifdef USE_ZLIB
-        // ignore errors, they're not relevant anymore
-        deflateEnd(&zs);
-        free(z_buffer);
+        if (!precompressed)
+        {
+            // ignore errors, they're not relevant anymore
+#ifdef USE_ZSTD
+            if (zc)
+                ZSTD_freeCCtx(zc);
+            else
+#endif
+            deflateEnd(&zs);
+            free(z_buffer);
+        }
 #endif
         return;
     }
 
 #ifdef USE_ZLIB
+    if (!precompressed)
+        finish_deflate();
+#endif
+    if (cur_block)
+        finish_block(0);
+    pkg->finish_chunk(name, first_block, codec);
+}
+
+#ifdef USE_ZLIB
+void chunk_writer::finish_deflate()
+{
+#ifdef USE_ZSTD
+    if (zc)
+    {
+        ZSTD_inBuffer in = { nullptr, 0, 0 };
+        size_t left;
+        do
+        {
+            ZSTD_outBuffer out = { z_buffer, ZB_SIZE, 0 };
+            left = ZSTD_compressStream2(zc, &out, &in, ZSTD_e_end);
+            if (ZSTD_isError(left))
+            {
+                fail("save file compression failed: %s",
+                     ZSTD_getErrorName(left));
+            }
+            raw_write(z_buffer, out.pos);
+        } while (left);
+        ZSTD_freeCCtx(zc);
+        zc = nullptr;
+        free(z_buffer);
+        return;
+    }
+#endif
+
     zs.avail_in = 0;
     int res;
     do
@@ -732,11 +1396,8 @@ chunk_writer::~chunk_writer()
     if (deflateEnd(&zs) != Z_OK)
         fail("save file compression failed during clean-up: %s", zs.msg);
     free(z_buffer);
-#endif
-    if (cur_block)
-        finish_block(0);
-    pkg->finish_chunk(name, first_block);
 }
+#endif
 
 void chunk_writer::raw_write(const void *data, plen_t len)
 {
@@ -781,6 +1442,27 @@ void chunk_writer::write(const void *data, plen_t len)
 {
     ASSERT(data);
     ASSERT(!pkg->aborted);
+    ASSERT(!precompressed);
+
+#ifdef USE_ZSTD
+    if (zc)
+    {
+        ZSTD_inBuffer in = { data, len, 0 };
+        while (in.pos < in.size)
+        {
+            ZSTD_outBuffer out = { z_buffer, ZB_SIZE, 0 };
+            const size_t res = ZSTD_compressStream2(zc, &out, &in,
+                                                    ZSTD_e_continue);
+            if (ZSTD_isError(res))
+            {
+                fail("save file compression failed: %s",
+                     ZSTD_getErrorName(res));
+            }
+            raw_write(z_buffer, out.pos);
+        }
+        return;
+    }
+#endif
 
 #ifdef USE_ZLIB
     zs.next_in  = (Bytef*)data;
@@ -804,6 +1486,7 @@ void chunk_writer::write(const void *data, plen_t len)
 
 void chunk_reader::init(plen_t start)
 {
+    package_guard g(pkg->bg);
     ASSERT(!pkg->aborted);
     pkg->n_users++;
     pkg->reader_count[start]++;
@@ -822,9 +1505,58 @@ void chunk_reader::init(plen_t start)
     if (inflateInit(&zs))
         fail("save file decompression failed during init: %s", zs.msg);
     eof = false;
+    started = false;
+    codec = SAVE_CODEC_ZLIB;
+#endif
+#ifdef USE_ZSTD
+    zd = nullptr;
 #endif
 }
 
+#ifdef USE_ZLIB
+// Read the first data, and see which codec it's in.
+void chunk_reader::start()
+{
+    started = true;
+    zs.next_in  = z_buffer;
+    zs.avail_in = raw_read(z_buffer, sizeof(z_buffer));
+    if (!zs.avail_in)
+        corrupted("save file corrupted -- block truncated");
+    if (z_buffer[0] != ZSTD_CHUNK_TAG)
+        return;
+
+#ifdef USE_ZSTD
+    if (zs.avail_in < ZSTD_TAG_LEN)
+        corrupted("save file corrupted -- block truncated");
+    codec = SAVE_CODEC_ZSTD;
+
+    uint32_t dict_id;
+    memcpy(&dict_id, z_buffer + 1, sizeof(dict_id));
+    dict_id = htole32(dict_id);
+
+    zd = ZSTD_createDCtx();
+    if (!zd)
+        fail("save file decompression failed during init");
+    if (dict_id)
+    {
+        const save_dictionary *dict = map_find(save_dictionaries, dict_id);
+        if (!dict)
+        {
+            fail("the save file needs compression dictionary %u, which "
+                 "isn't loaded (see save_compression_dict)", dict_id);
+        }
+        ZSTD_DCtx_refDDict(zd, dict->ddict);
+    }
+    zin.src  = z_buffer;
+    zin.size = zs.avail_in;
+    zin.pos  = ZSTD_TAG_LEN;
+#else
+    fail("the save file uses zstd compression, which this build doesn't "
+         "support");
+#endif
+}
+#endif
+
 chunk_reader::chunk_reader(package *parent, plen_t start)
 {
     ASSERT(parent);
@@ -836,6 +1568,7 @@ chunk_reader::chunk_reader(package *parent, plen_t start)
 chunk_reader::chunk_reader(package *parent, const string &_name)
 {
     ASSERT(parent);
+    parent->flush_chunk(_name);
     if (!parent->has_chunk(_name))
         corrupted("save file corrupted -- chunk \"%s\" missing", _name.c_str());
     dprintf("chunk_reader(%s): starting\n", _name.c_str());
@@ -847,10 +1580,15 @@ chunk_reader::~chunk_reader()
 {
     dprintf("chunk_reader: closing\n");
 
+#ifdef USE_ZSTD
+    if (zd)
+        ZSTD_freeDCtx(zd);
+#endif
 #ifdef USE_ZLIB
     if (inflateEnd(&zs) != Z_OK)
         fail("save file decompression failed during clean-up: %s", zs.msg);
 #endif
+    package_guard g(pkg->bg);
     ASSERT(pkg->reader_count[first_block] > 0);
     if (!--pkg->reader_count[first_block])
         pkg->reader_count.erase(first_block);
@@ -860,6 +1598,8 @@ chunk_reader::~chunk_reader()
 
 plen_t chunk_reader::raw_read(void *data, plen_t len)
 {
+    // The background writer shares the file offset.
+    package_guard g(pkg->bg);
     void *buf = data;
     while (len)
     {
@@ -915,6 +1655,37 @@ plen_t chunk_reader::read(void *data, plen_t len)
         return 0;
     if (eof)
         return 0;
+    if (!started)
+        start();
+
+#ifdef USE_ZSTD
+    if (codec == SAVE_CODEC_ZSTD)
+    {
+        ZSTD_outBuffer out = { data, len, 0 };
+        while (out.pos < out.size)
+        {
+            if (zin.pos == zin.size)
+            {
+                zin.size = raw_read(z_buffer, sizeof(z_buffer));
+                zin.pos  = 0;
+                if (!zin.size)
+                    corrupted("save file corrupted -- block truncated");
+            }
+            const size_t res = ZSTD_decompressStream(zd, &out, &zin);
+            if (ZSTD_isError(res))
+            {
+                corrupted("save file decompression failed: %s",
+                          ZSTD_getErrorName(res));
+            }
+            if (!res)
+            {
+                eof = true;
+                break;
+            }
+        }
+        return out.pos;
+    }
+#endif
 
     zs.next_out  = (Bytef*)data;
     zs.avail_out = len;
@@ -8,16 +8,50 @@
 #ifdef USE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #if !defined(DGAMELAUNCH) && !defined(__ANDROID__) && !defined(DEBUG_DIAGNOSTICS)
 #define DO_FSYNC
 #endif
 
+// Saves can be written by a background thread; see package::start_async().
+#if !defined(TARGET_OS_WINDOWS) && !defined(__ANDROID__)
+#define ASYNC_SAVES
+#endif
+
 #define MAX_CHUNK_NAME_LENGTH 255
 
+// How long a crash waits for the background writer; see
+// package::drain_async_for_crash().
+#define SAVE_CRASH_DRAIN_MS 10000
+
 typedef uint32_t plen_t;
 
 class package;
+struct package_async;
+
+// How chunks are compressed. Each chunk records its own codec, so a save
+// may mix them; zlib chunks are the original format.
+enum save_codec
+{
+    SAVE_CODEC_ZLIB,
+    SAVE_CODEC_ZSTD,
+    NUM_SAVE_CODECS
+};
+
+struct save_compression
+{
+    save_codec codec = SAVE_CODEC_ZLIB;
+    int level = 0;      // 0 for the codec's default
+    uint32_t dict = 0;  // from load_save_dictionary(), or 0 for none
+};
+
+bool save_codec_available(save_codec codec);
+bool parse_save_compression(const string &spec, save_compression &comp,
+                            string &error);
+uint32_t load_save_dictionary(const string &file);
 
 class chunk_writer
 {
@@ -27,14 +61,26 @@ private:
     plen_t first_block;
     plen_t cur_block;
     plen_t block_len;
+    bool precompressed;
+    save_codec codec;
 #ifdef USE_ZLIB
     z_stream zs;
     Bytef *z_buffer;
+#endif
+#ifdef USE_ZSTD
+    ZSTD_CCtx *zc;
 #endif
     void raw_write(const void *data, plen_t len);
     void finish_block(plen_t next);
+#ifdef USE_ZLIB
+    void finish_deflate();
+#endif
 public:
-    chunk_writer(package *parent, const string &_name);
+    // The package's dictionary, if any, is only used when use_dict is set.
+    // A precompressed writer takes data already in the on-disk format,
+    // through raw_write() only.
+    chunk_writer(package *parent, const string &_name, bool use_dict = false,
+                 bool precompressed = false);
     ~chunk_writer();
     void write(const void *data, plen_t len);
     friend class package;
@@ -50,10 +96,19 @@ private:
     plen_t off, block_left;
 #ifdef USE_ZLIB
     bool eof;
+    bool started;
+    save_codec codec;
     z_stream zs;
     Bytef z_buffer[32768];
+#endif
+#ifdef USE_ZSTD
+    ZSTD_DCtx *zd;
+    ZSTD_inBuffer zin;
 #endif
     plen_t raw_read(void *data, plen_t len);
+#ifdef USE_ZLIB
+    void start();
+#endif
 public:
     chunk_reader(package *parent, const string &_name);
     ~chunk_reader();
@@ -68,7 +123,7 @@ public:
     package(const char* file, bool writeable, bool empty = false);
     package();
     ~package();
-    chunk_writer* writer(const string &name);
+    chunk_writer* writer(const string &name, bool use_dict = false);
     chunk_reader* reader(const string &name);
     void commit();
     void delete_chunk(const string &name);
@@ -77,6 +132,21 @@ public:
     void abort();
     void unlink();
 
+    // Asynchronous saving: once started, write_chunk() and commit() queue
+    // their work for a background thread and return at once. Reads of a
+    // chunk with a write still queued, and everything else that changes
+    // the package, wait for the queue to drain first.
+    void start_async();
+    void stop_async();
+    bool is_async() const { return bg; }
+    void flush();
+    bool drain_async_for_crash(int timeout_ms);
+    void write_chunk(const string &name, vector<unsigned char> data,
+                     bool use_dict = false);
+
+    // Applies to chunks written from now on.
+    void set_compression(const save_compression &comp);
+
     // statistics
     plen_t get_slack();
     plen_t get_size() const { return file_len; };
@@ -90,10 +160,13 @@ private:
     int n_users;
     bool dirty;
     bool aborted;
+    package_async *bg;
+    save_compression compression;
 #ifdef DO_FSYNC
     bool tmp;
 #endif
     map<string, plen_t> directory;
+    set<string> zstd_chunks;    // that older versions can't read
     map<plen_t, plen_t> free_blocks;
     vector<plen_t> unlinked_blocks;
     map<plen_t, pair<plen_t, plen_t> > block_map;
@@ -101,7 +174,7 @@ private:
     map<plen_t, uint32_t> reader_count;
     plen_t extend_block(plen_t at, plen_t size, plen_t by);
     plen_t alloc_block(plen_t &size);
-    void finish_chunk(const string &name, plen_t at);
+    void finish_chunk(const string &name, plen_t at, save_codec codec);
     void free_chunk(const string &name);
     plen_t write_directory();
     void collect_blocks();
@@ -113,6 +186,13 @@ private:
     void trace_chunk(plen_t start);
     void load();
     void load_traces();
+    void commit_now();
+    void flush_chunk(const string &name);
+    void write_precompressed(const string &name,
+                             const vector<unsigned char> &data);
+    void compress_chunk(const vector<unsigned char> &in,
+                        vector<unsigned char> &out, bool use_dict);
+    static void *async_main(void *pkg);
     friend class chunk_writer;
     friend class chunk_reader;
 };
@@ -540,7 +540,9 @@ void show_init(layers_type layers)
 
     ASSERT(you.on_current_level);
 
-    vector <coord_def> update_locs;
+    // Kept between calls, as this runs on every redraw.
+    static vector<coord_def> update_locs;
+    update_locs.clear();
     for (radius_iterator ri(you.pos(), you.xray_vision ? LOS_NONE : LOS_DEFAULT); ri; ++ri)
     {
         show_update_at(*ri, layers);
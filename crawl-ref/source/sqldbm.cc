@@ -14,10 +14,17 @@
 #endif
 
 #include "end.h"
+#include "stringutil.h"
 #include "syscalls.h"
 
 #ifdef USE_SQLITE_DBM
 
+// Upper bound on how much of a read-only database is memory mapped; this is
+// comfortably larger than any of the text databases.
+static const int SQL_DBM_MMAP_SIZE = 64 * 1024 * 1024;
+// Pages of private cache per read-only connection, on top of the shared map.
+static const int SQL_DBM_PRIVATE_CACHE_PAGES = 16;
+
 class sqlite_retry_iterator
 {
 public:
@@ -120,6 +127,8 @@ From SQLite's documentation:
     }
 
     init_schema();
+    if (readonly)
+        init_shared_read();
     return errc;
 }
 
@@ -144,6 +153,19 @@ int SQL_DBM::init_schema()
     return err;
 }
 
+// Read-only databases (the text databases) are opened by every game process
+// on a server. Reading them through a shared memory map lets all of those
+// processes share one copy of the pages in the OS page cache, instead of each
+// connection filling its own private page cache with copies of them.
+void SQL_DBM::init_shared_read()
+{
+    const string pragmas =
+        make_stringf("PRAGMA mmap_size=%d; PRAGMA cache_size=%d;",
+                     SQL_DBM_MMAP_SIZE, SQL_DBM_PRIVATE_CACHE_PAGES);
+    // Older SQLites don't know about mmap_size and ignore it, which is fine.
+    sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, nullptr);
+}
+
 void SQL_DBM::close()
 {
     if (db)
@@ -74,6 +74,7 @@ private:
     int init_insert();
     int init_remove();
     int init_schema();
+    void init_shared_read();
     int ec(int err);
 
     int try_insert(const string &key, const string &value);
@@ -239,6 +239,8 @@ bool Stash::unmark_trapping_nets()
     for (auto &item : items)
         if (item_is_stationary_net(item))
             item.net_placed = false, changed = true;
+    if (changed)
+        search_text_gen = -1;
     return changed;
 }
 
@@ -266,6 +268,7 @@ void Stash::update()
 
     // Zap existing items
     items.clear();
+    search_text_gen = -1;
 
     if (!_grid_has_perceived_item(pos))
     {
@@ -368,6 +371,54 @@ string Stash::feature_description() const
     return feat_desc;
 }
 
+// Bumped when something that all item search text depends on changes, so
+// that every stash rebuilds its text when next searched.
+static int _search_text_gen = 0;
+
+/**
+ * Check whether the player has learned anything since the last search that
+ * would change the names or annotations of items they haven't picked up
+ * again since: item types they've identified, or a new form (which can
+ * change what is {throwable}).
+ */
+static void _check_search_text_gen()
+{
+    static id_arr type_ids;
+    static transformation form = transformation::none;
+
+    bool changed = form != you.form;
+    for (int i = 0; i < NUM_OBJECT_CLASSES && !changed; i++)
+        for (int j = 0; j < MAX_SUBTYPES; j++)
+            if (type_ids[i][j] != you.type_ids[i][j])
+                changed = true;
+
+    if (changed)
+    {
+        type_ids = you.type_ids;
+        form = you.form;
+        _search_text_gen++;
+    }
+}
+
+const vector<item_search_text> &Stash::get_search_text() const
+{
+    if (search_text_gen != _search_text_gen
+        || search_text.size() != items.size())
+    {
+        search_text.clear();
+        for (const item_def &item : items)
+        {
+            search_text.push_back({
+                stash_item_name(item),
+                stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item),
+                is_dumpable_artefact(item) ? chardump_desc(item) : ""
+            });
+        }
+        search_text_gen = _search_text_gen;
+    }
+    return search_text;
+}
+
 vector<stash_search_result> Stash::matches_search(
     const string &prefix, const base_pattern &search) const
 {
@@ -375,12 +426,13 @@ vector<stash_search_result> Stash::matches_search(
     if (empty())
         return results;
 
-    for (const item_def &item : items)
+    const vector<item_search_text> &text = get_search_text();
+    for (size_t i = 0; i < items.size(); ++i)
     {
-        const string s   = stash_item_name(item);
-        const string ann = stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item);
-        if (search.matches(prefix + " " + ann + " " + s)
-            || is_dumpable_artefact(item) && search.matches(chardump_desc(item)))
+        const item_def &item = items[i];
+        const string &s = text[i].name;
+        if (search.matches(prefix + " " + text[i].annotation + " " + s)
+            || is_dumpable_artefact(item) && search.matches(text[i].desc))
         {
             stash_search_result res;
             res.match_type = MATCH_ITEM;
@@ -426,9 +478,11 @@ void Stash::_update_corpses(int rot_time)
         if (new_rot <= _min_rot(item))
         {
             items.erase(items.begin() + i);
+            search_text_gen = -1;
             continue;
         }
         item.stash_freshness = static_cast<short>(new_rot);
+        search_text_gen = -1;
     }
 }
 
@@ -436,8 +490,11 @@ void Stash::_update_identification()
 {
     for (int i = items.size() - 1; i >= 0; i--)
     {
+        const iflags_t old_flags = items[i].flags;
         god_id_item(items[i]);
         maybe_identify_base_type(items[i]);
+        if (items[i].flags != old_flags)
+            search_text_gen = -1;
     }
 }
 
@@ -450,6 +507,7 @@ void Stash::add_item(const item_def &item, bool add_to_front)
         items.insert(items.begin(), item);
     else
         items.push_back(item);
+    search_text_gen = -1;
 
     seen_item(item);
 
@@ -554,6 +612,7 @@ void Stash::load(reader& inf)
 
     // Zap out item vector, in case it's in use (however unlikely)
     items.clear();
+    search_text_gen = -1;
     // Read in the items
     for (int i = 0; i < count; ++i)
     {
@@ -608,6 +667,26 @@ void ShopInfo::show_menu(const level_pos& pos) const
     // ShopMenu shouldn't actually modify the shop, since it only does so if
     // you buy something.
     ::shop(const_cast<shop_struct&>(shop), pos);
+    search_text_gen = -1;
+}
+
+const vector<item_search_text> &ShopInfo::get_search_text() const
+{
+    if (search_text_gen != _search_text_gen
+        || search_text.size() != shop.stock.size())
+    {
+        search_text.clear();
+        for (const item_def &item : shop.stock)
+        {
+            search_text.push_back({
+                shop_item_name(item),
+                stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item),
+                shop_item_desc(item)
+            });
+        }
+        search_text_gen = _search_text_gen;
+    }
+    return search_text;
 }
 
 vector<stash_search_result> ShopInfo::matches_search(
@@ -635,15 +714,15 @@ vector<stash_search_result> ShopInfo::matches_search(
         }
     }
 
-    for (const item_def &item : shop.stock)
+    const vector<item_search_text> &text = get_search_text();
+    for (size_t i = 0; i < shop.stock.size(); ++i)
     {
-        const string sname = shop_item_name(item);
-        const string ann   = stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE,
-                                                 &item);
+        const item_def &item = shop.stock[i];
+        const string &sname = text[i].name;
 
-        if (search.matches(prefix + " " + ann + " " + sname +
+        if (search.matches(prefix + " " + text[i].annotation + " " + sname +
                                                     " {" + shoptitle + "}")
-            || search.matches(shop_item_desc(item)))
+            || search.matches(text[i].desc))
         {
             stash_search_result res;
             res.match_type = MATCH_ITEM;
@@ -1489,6 +1568,8 @@ void StashTracker::get_matching_stashes(
         bool curr_lev)
     const
 {
+    _check_search_text_gen();
+
     level_id curr = level_id::current();
     for (const auto &entry : levels)
     {
@@ -18,6 +18,16 @@ class writer;
 class StashMenu;
 
 struct stash_search_result;
+
+// What a stash search looks at for one item, kept between searches since
+// building it (through the Lua annotation hook, in particular) is slow.
+struct item_search_text
+{
+    string name;        // Stash::stash_item_name() or the shop listing
+    string annotation;  // from STASH_LUA_SEARCH_ANNOTATE
+    string desc;        // artefact description, if any
+};
+
 class Stash
 {
 public:
@@ -65,6 +75,7 @@ private:
     void _update_corpses(int rot_time);
     void _update_identification();
     void add_item(const item_def &item, bool add_to_front = false);
+    const vector<item_search_text> &get_search_text() const;
 
 private:
     bool visited;      // Is this correct to the best of our knowledge?
@@ -75,6 +86,11 @@ private:
 
     vector<item_def> items;
 
+    // Search text for items, rebuilt when it's needed after they change
+    // or the player learns something about them. -1 means out of date.
+    mutable vector<item_search_text> search_text;
+    mutable int search_text_gen = -1;
+
     static bool are_items_same(const item_def &, const item_def &,
                                bool exact = false);
 
@@ -104,6 +120,11 @@ public:
 private:
     string shop_item_name(const item_def &it) const;
     string shop_item_desc(const item_def &it) const;
+    const vector<item_search_text> &get_search_text() const;
+
+    // As for Stash, but for the shop's stock.
+    mutable vector<item_search_text> search_text;
+    mutable int search_text_gen = -1;
 
     friend class ST_ItemIterator;
 };
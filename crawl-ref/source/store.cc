@@ -1215,10 +1215,22 @@ void CrawlHashTable::write(writer &th) const
 
     marshallUnsigned(th, size());
 
+    // Entries are kept in hash order; write them in key order, as when the
+    // table was a map, so that saves come out the same.
+    vector<const value_type *> entries;
+    entries.reserve(size());
     for (const auto &entry : *this)
+        entries.push_back(&entry);
+    sort(entries.begin(), entries.end(),
+         [](const value_type *a, const value_type *b)
+         {
+             return a->first < b->first;
+         });
+
+    for (const value_type *entry : entries)
     {
-        marshallString(th, entry.first);
-        entry.second.write(th);
+        marshallString(th, entry->first);
+        entry->second.write(th);
     }
 
     ASSERT_VALIDITY();
@@ -1253,7 +1265,7 @@ void CrawlHashTable::read(reader &th)
 
 #ifdef DEBUG_PROPS
 static map<string, int> accesses;
-# define ACCESS(x) ++accesses[x]
+# define ACCESS(x) ++accesses[x.str()]
 #else
 # define ACCESS(x)
 #endif
@@ -1261,11 +1273,64 @@ static map<string, int> accesses;
 //////////////////
 // Misc functions
 
-bool CrawlHashTable::exists(const string &key) const
+CrawlHashTable::CrawlHashTable(const CrawlHashTable &other)
+{
+    *this = other;
+}
+
+CrawlHashTable &CrawlHashTable::operator = (const CrawlHashTable &other)
+{
+    if (&other == this)
+        return *this;
+
+    slots.clear();
+    slots.reserve(other.slots.size());
+    for (const slot &s : other.slots)
+    {
+        slots.push_back({s.hash,
+                         unique_ptr<value_type>(new value_type(*s.entry))});
+    }
+    return *this;
+}
+
+// The first slot that would come at or after key, in (hash, key) order.
+CrawlHashTable::slot_vector::const_iterator
+CrawlHashTable::_lower_bound(const prop_key &key) const
+{
+    return lower_bound(slots.begin(), slots.end(), key,
+        [](const slot &s, const prop_key &k)
+        {
+            if (s.hash != k.hash)
+                return s.hash < k.hash;
+            return s.entry->first.compare(0, string::npos, k.chars, k.len) < 0;
+        });
+}
+
+size_t CrawlHashTable::_find(const prop_key &key) const
+{
+    const auto it = _lower_bound(key);
+    if (it != slots.end() && it->hash == key.hash
+        && key.matches(it->entry->first))
+    {
+        return it - slots.begin();
+    }
+    return slots.size();
+}
+
+bool CrawlHashTable::exists(const prop_key &key) const
 {
     ACCESS(key);
     ASSERT_VALIDITY();
-    return find(key) != end();
+    return _find(key) != slots.size();
+}
+
+size_t CrawlHashTable::erase(const prop_key &key)
+{
+    const size_t i = _find(key);
+    if (i == slots.size())
+        return 0;
+    slots.erase(slots.begin() + i);
+    return 1;
 }
 
 void CrawlHashTable::assert_validity() const
@@ -1332,22 +1397,29 @@ void CrawlHashTable::assert_validity() const
 ////////////////////////////////
 // Accessors to contained values
 
-CrawlStoreValue& CrawlHashTable::get_value(const string &key)
+CrawlStoreValue& CrawlHashTable::get_value(const prop_key &key)
 {
     ASSERT_VALIDITY();
     ACCESS(key);
-    // Inserts CrawlStoreValue() if the key was not found.
-    return map::operator[](key);
+    const size_t i = _find(key);
+    if (i != slots.size())
+        return slots[i].entry->second;
+
+    auto pos = slots.begin() + (_lower_bound(key) - slots.begin());
+    pos = slots.insert(pos, {key.hash, unique_ptr<value_type>(
+                                new value_type(key.str(), CrawlStoreValue()))});
+    return pos->entry->second;
 }
 
-const CrawlStoreValue& CrawlHashTable::get_value(const string &key) const
+const CrawlStoreValue& CrawlHashTable::get_value(const prop_key &key) const
 {
     ASSERT_VALIDITY();
     ACCESS(key);
-    auto iter = find(key);
-    ASSERTM(iter != end(), "trying to read non-existent property \"%s\"", key.c_str());
+    const size_t i = _find(key);
+    ASSERTM(i != slots.size(), "trying to read non-existent property \"%s\"",
+            key.str().c_str());
 
-    const CrawlStoreValue& store = iter->second;
+    const CrawlStoreValue& store = slots[i].entry->second;
     ASSERT(store.type != SV_NONE);
     ASSERT(!(store.flags & SFLAG_UNSET));
 
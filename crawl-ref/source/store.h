@@ -8,6 +8,7 @@
 
 #include <climits>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -241,27 +242,132 @@ protected:
     friend class CrawlVector;
 };
 
-class CrawlHashTable : public map<string, CrawlStoreValue>
+/**
+ * A key into a CrawlHashTable: the key's characters along with their hash,
+ * which is constexpr so that the compiler can work it out for literal keys.
+ * Looking a key up then compares hashes, and only compares strings when
+ * those match, without ever building a string.
+ */
+class prop_key
+{
+public:
+    constexpr prop_key(const char *key)
+        : chars(key), len(_length(key)), hash(_hash(key)) { }
+    prop_key(const string &key)
+        : chars(key.c_str()), len(key.size()), hash(_hash(key.c_str())) { }
+
+    bool matches(const string &key) const
+    {
+        return key.size() == len && !key.compare(0, len, chars, len);
+    }
+    string str() const { return string(chars, len); }
+
+    const char *chars;
+    size_t      len;
+    uint32_t    hash;
+
+private:
+    // FNV-1a, written so that it can be constexpr under C++11.
+    static constexpr uint32_t _hash(const char *s, uint32_t h = 2166136261u)
+    {
+        return *s ? _hash(s + 1, (h ^ uint8_t(*s)) * 16777619u) : h;
+    }
+    static constexpr size_t _length(const char *s, size_t n = 0)
+    {
+        return *s ? _length(s + 1, n + 1) : n;
+    }
+};
+
+/**
+ * A hash table of CrawlStoreValues keyed by strings, with the interface of
+ * the map<string, CrawlStoreValue> it used to be. Entries live in a flat
+ * vector sorted by each key's hash (then by key), so that lookups are a
+ * binary search over integers. Iteration goes in that order, not by key;
+ * marshalling still writes entries in key order.
+ *
+ * Like a map, adding or erasing entries doesn't move the values of any
+ * others, so references to values stay valid. Unlike a map, adding or
+ * erasing an entry invalidates all iterators into the table.
+ */
+class CrawlHashTable
 {
 public:
     friend class CrawlStoreValue;
 
+    typedef string                               key_type;
+    typedef CrawlStoreValue                      mapped_type;
+    typedef pair<const string, CrawlStoreValue>  value_type;
+
+private:
+    struct slot
+    {
+        uint32_t                   hash;
+        unique_ptr<value_type>     entry;
+    };
+    typedef vector<slot> slot_vector;
+
+    template <class I, class V>
+    class iter
+    {
+    public:
+        iter() { }
+        iter(I _it) : it(_it) { }
+        template <class I2, class V2>
+        iter(const iter<I2, V2> &other) : it(other.it) { }
+
+        V &operator*() const { return *it->entry; }
+        V *operator->() const { return it->entry.get(); }
+        iter &operator++() { ++it; return *this; }
+        iter operator++(int) { iter old = *this; ++it; return old; }
+        bool operator==(const iter &other) const { return it == other.it; }
+        bool operator!=(const iter &other) const { return it != other.it; }
+
+        I it;
+    };
+
+public:
+    typedef iter<slot_vector::iterator, value_type> iterator;
+    typedef iter<slot_vector::const_iterator, const value_type>
+        const_iterator;
+
+    CrawlHashTable() { }
+    CrawlHashTable(const CrawlHashTable &other);
+    CrawlHashTable(CrawlHashTable &&other) = default;
+    CrawlHashTable &operator = (const CrawlHashTable &other);
+    CrawlHashTable &operator = (CrawlHashTable &&other) = default;
+
     void write(writer &) const;
     void read(reader &);
 
-    bool exists(const string &key) const;
+    bool exists(const prop_key &key) const;
 
     void assert_validity() const;
 
+    // map style interface
+    iterator begin() { return iterator(slots.begin()); }
+    iterator end() { return iterator(slots.end()); }
+    const_iterator begin() const { return const_iterator(slots.begin()); }
+    const_iterator end() const { return const_iterator(slots.end()); }
+
+    size_t size() const { return slots.size(); }
+    bool   empty() const { return slots.empty(); }
+    void   clear() { slots.clear(); }
+
+    iterator find(const prop_key &key)
+    { return iterator(slots.begin() + _find(key)); }
+    const_iterator find(const prop_key &key) const
+    { return const_iterator(slots.begin() + _find(key)); }
+    size_t count(const prop_key &key) const
+    { return _find(key) != slots.size(); }
+
+    size_t   erase(const prop_key &key);
+    iterator erase(iterator pos) { return iterator(slots.erase(pos.it)); }
+
     // NOTE: If the const versions of get_value() or [] are given a
     // key which doesn't exist, they will assert.
-    const CrawlStoreValue& get_value(const string &key) const;
-    const CrawlStoreValue& get_value(const char *key) const
-    { return get_value(string(key)); }
-    const CrawlStoreValue& operator[] (const string &key) const
+    const CrawlStoreValue& get_value(const prop_key &key) const;
+    const CrawlStoreValue& operator[] (const prop_key &key) const
     { return get_value(key); }
-    const CrawlStoreValue& operator[] (const char *key) const
-    { return get_value(string(key)); }
 
     // NOTE: If get_value() or [] is given a key which doesn't exist
     // in the table, an unset/empty CrawlStoreValue will be created
@@ -270,12 +376,15 @@ public:
     // hash table has a type (rather than being heterogeneous)
     // then trying to assign a different type to the CrawlStoreValue
     // will assert.
-    CrawlStoreValue& get_value(const string &key);
-    CrawlStoreValue& get_value(const char *key)
-    { return get_value(string(key)); }
-    using map::operator[];
-    CrawlStoreValue& operator[] (const char *key)
-    { return get_value(string(key)); }
+    CrawlStoreValue& get_value(const prop_key &key);
+    CrawlStoreValue& operator[] (const prop_key &key)
+    { return get_value(key); }
+
+private:
+    slot_vector::const_iterator _lower_bound(const prop_key &key) const;
+    size_t _find(const prop_key &key) const;
+
+    slot_vector slots;
 };
 
 // A CrawlVector is the vector version of CrawlHashTable, except that
@@ -136,6 +136,11 @@ void reader::close()
 
 void reader::advance(size_t offset)
 {
+    // Plain files can be skipped over without reading through them; this is
+    // what makes lazily loading a single map out of the .dsc cache cheap.
+    if (_file && fseek(_file, offset, SEEK_CUR) == 0)
+        return;
+
     char junk[128];
 
     while (offset)
@@ -6324,6 +6329,7 @@ void unmarshallMonster(reader &th, monster& m)
     m.type = unmarshallMonType(th);
     if (m.type == MONS_NO_MONSTER)
         return;
+    m.update_slot_index(true);
 
     ASSERT(!invalid_monster_type(m.type));
 
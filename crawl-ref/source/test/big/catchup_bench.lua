@@ -0,0 +1,29 @@
+-- Time how long levels take to catch up on monsters when the player comes
+-- back to them after a long time away.
+--
+-- Run with: ./crawl -test big/catchup_bench
+
+local PLACES = { "D:5", "D:12", "Lair:3", "Orc:2", "Elf:3", "Vaults:4",
+                 "Crypt:2", "Zot:3" }
+local AWAY = { 100, 10000, 100000 }
+
+debug.disable('death')
+
+local totals = {}
+for _, place in ipairs(PLACES) do
+  for i, turns in ipairs(AWAY) do
+    debug.goto_place(place)
+    debug.flush_map_memory()
+    debug.generate_level()
+
+    local ms, count = debug.catchup_benchmark(turns)
+    crawl.message(string.format("%-9s %6d turns away: %7.2f ms, %d monsters",
+                                place, turns, ms, count))
+    totals[i] = (totals[i] or 0) + ms
+  end
+end
+
+for i, turns in ipairs(AWAY) do
+  crawl.message(string.format("Total after %d turns away: %.2f ms", turns,
+                              totals[i]))
+end
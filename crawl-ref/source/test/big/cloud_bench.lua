@@ -0,0 +1,49 @@
+-- Benchmark cloud upkeep and monster movement on an open level covered in
+-- clouds, as in the fireworks stress test.
+--
+-- Run with: ./crawl -test big/cloud_bench
+
+crawl_require('dlua/stress.lua')
+
+local ROUNDS = 10
+local TURNS = 20
+local CLOUDS = { "grey smoke", "blue smoke", "purple smoke", "thin mist",
+                 "steam" }
+
+debug.disable('death')
+debug.goto_place("D:2")
+debug.flush_map_memory()
+debug.generate_level()
+debug.dismiss_monsters()
+stress.fill_level('floor')
+
+local gxm, gym = dgn.max_bounds()
+for y = 4, gym - 5, 3 do
+  for x = 4, gxm - 5, 3 do
+    dgn.create_monster(x, y, 'goblin hp:10000')
+  end
+end
+you.teleport_to(2, 2)
+
+-- Refill the level with clouds every round, so that it stays covered.
+local function spam_clouds()
+  for p in iter.rect_iterator(dgn.point(1, 1), dgn.point(gxm - 2, gym - 2)) do
+    if crawl.one_chance_in(2) then
+      dgn.place_cloud(p.x, p.y, CLOUDS[crawl.random_range(1, #CLOUDS)],
+                      crawl.random_range(5, 20))
+    end
+  end
+end
+
+local total_clouds, total_mons, total_count = 0, 0, 0
+for round = 1, ROUNDS do
+  spam_clouds()
+  local cloud_ms, mons_ms, count = debug.cloud_benchmark(TURNS)
+  total_clouds = total_clouds + cloud_ms
+  total_mons = total_mons + mons_ms
+  total_count = total_count + count
+end
+
+crawl.message(string.format(
+  "%d turns: clouds %.1f ms, monsters %.1f ms, %d clouds left on average",
+  ROUNDS * TURNS, total_clouds, total_mons, total_count / ROUNDS))
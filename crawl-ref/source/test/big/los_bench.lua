@@ -0,0 +1,27 @@
+-- Benchmark losight() against the reference ray-by-ray implementation on
+-- generated levels, and check that both agree.
+--
+-- Run with: ./crawl -test big/los_bench
+
+local ITERATIONS = 5
+local PLACES = { "D:2", "D:10", "Lair:3", "Orc:2", "Elf:3", "Vaults:4",
+                 "Crypt:2", "Zot:3" }
+
+local total_fast, total_ref = 0, 0
+for _, place in ipairs(PLACES) do
+  debug.goto_place(place)
+  debug.flush_map_memory()
+  debug.generate_level()
+
+  local fast, ref, mismatches = los.benchmark(ITERATIONS)
+  crawl.message(string.format("%-9s losight %8.1f ms, reference %8.1f ms",
+                              place, fast, ref))
+  assert(mismatches == 0,
+         "losight differs from reference in " .. mismatches .. " cells on "
+           .. place)
+  total_fast = total_fast + fast
+  total_ref = total_ref + ref
+end
+
+crawl.message(string.format("Total: losight %.1f ms, reference %.1f ms (%.2fx)",
+                            total_fast, total_ref, total_ref / total_fast))
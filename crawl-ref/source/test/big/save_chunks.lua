@@ -0,0 +1,31 @@
+-- Hop up and down stairs and report, per chunk, how often save_game_state()
+-- wrote it or skipped it as unchanged, and what writing it cost.
+--
+-- Run with: ./crawl -test big/save_chunks
+
+local HOPS = 50
+
+debug.goto_place("D:3")
+debug.flush_map_memory()
+debug.generate_level()
+
+for i = 1, HOPS do
+  debug.down_stairs()
+  debug.up_stairs()
+end
+
+local total_written, total_skipped, total_usec = 0, 0, 0
+for _, st in ipairs(debug.save_chunk_stats()) do
+  crawl.message(string.format("%-13s written %4d, skipped %4d, "
+                                .. "%7d bytes, %8.1f ms",
+                              st.name, st.written, st.skipped, st.bytes,
+                              st.usec / 1000))
+  total_written = total_written + st.written
+  total_skipped = total_skipped + st.skipped
+  total_usec = total_usec + st.usec
+end
+
+assert(total_written + total_skipped > 0, "no chunks were saved")
+crawl.message(string.format("Total: %d written, %d skipped, %.1f ms",
+                            total_written, total_skipped,
+                            total_usec / 1000))
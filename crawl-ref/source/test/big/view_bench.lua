@@ -0,0 +1,33 @@
+-- Walk the player across an open level, redrawing the view at every step
+-- as travel does, and count how many cells of each frame actually change.
+--
+-- Run with: ./crawl -test big/view_bench
+
+crawl_require('dlua/stress.lua')
+
+local STEPS = 60
+
+debug.goto_place("D:2")
+debug.flush_map_memory()
+debug.generate_level()
+debug.dismiss_monsters()
+stress.fill_level('floor')
+
+local gxm, gym = dgn.max_bounds()
+local y = math.floor(gym / 2)
+you.teleport_to(2, y)
+debug.viewwindow(true)
+
+local touched = 0
+for x = 3, math.min(2 + STEPS, gxm - 3) do
+  you.teleport_to(x, y)
+  touched = touched + debug.viewwindow(true)
+end
+
+-- Standing still, nothing should need redrawing.
+local still = debug.viewwindow(true)
+assert(still == 0, still .. " cells changed while standing still")
+
+crawl.message(string.format(
+  "%d steps: %.1f cells changed per frame, %d when standing still",
+  STEPS, touched / STEPS, still))
@@ -0,0 +1,64 @@
+-- Check that the global LOS cache stays correct across terrain changes.
+
+local FAILMAP = 'loscachefail.map'
+local checks = 0
+
+local function los_around(x, y)
+  local seen = { }
+  for dy = -8, 8 do
+    for dx = -8, 8 do
+      local px, py = x + dx, y + dy
+      if dgn.in_bounds(px, py) then
+        seen[dx .. "," .. dy] = los.cell_see_cell(x, y, px, py)
+      end
+    end
+  end
+  return seen
+end
+
+local function test_los_cache_invalidation()
+  you.random_teleport()
+  checks = checks + 1
+  local you_x, you_y = you.pos()
+
+  -- Fill the cache around the player, then knock down or raise some walls.
+  los_around(you_x, you_y)
+  for i = 1, 5 do
+    local x = you_x + crawl.random_range(-8, 8)
+    local y = you_y + crawl.random_range(-8, 8)
+    if dgn.in_bounds(x, y) and (x ~= you_x or y ~= you_y) then
+      if feat.is_wall(x, y) then
+        dgn.terrain_changed(x, y, "floor", false, false)
+      elseif dgn.grid(x, y) == dgn.feature_number("floor") then
+        dgn.terrain_changed(x, y, "rock_wall", false, false)
+      end
+    end
+  end
+
+  local cached = los_around(you_x, you_y)
+  debug.los_changed()
+  local fresh = los_around(you_x, you_y)
+
+  for k, v in pairs(fresh) do
+    if cached[k] ~= v then
+      debug.dump_map(FAILMAP)
+      assert(false,
+             "stale LOS cache entry (iter #" .. checks .. ") from "
+               .. dgn.point(you_x, you_y) .. " at offset " .. k
+               .. ". Map saved to " .. FAILMAP)
+    end
+  end
+end
+
+for depth = 1, 10 do
+  debug.goto_place("D:" .. depth)
+  debug.flush_map_memory()
+  debug.generate_level()
+  for t = 1, 5 do
+    test_los_cache_invalidation()
+  end
+end
+
+local hits, misses, invalidated, bytes = los.cache_stats()
+crawl.message("LOS cache: " .. hits .. " hits, " .. misses .. " misses, "
+              .. invalidated .. " invalidated, " .. bytes .. " bytes")
@@ -79,6 +79,7 @@ TilesFramework tiles;
 TilesFramework::TilesFramework() :
       m_controlled_from_web(false),
       _send_lock(false),
+      m_resyncing(false),
       m_last_ui_state(UI_INIT),
       m_view_loaded(false),
       m_current_view(coord_def(GXM, GYM)),
@@ -88,6 +89,10 @@ TilesFramework::TilesFramework() :
       m_current_flash_colour(BLACK),
       m_next_flash_colour(BLACK),
       m_need_full_map(true),
+      m_packed_map(false),
+      m_packed_send_gc(true),
+      m_map_frames(0),
+      m_map_bytes(0),
       m_text_menu("menu_txt"),
       m_print_fg(15)
 {
@@ -95,17 +100,59 @@ TilesFramework::TilesFramework() :
     default_cell.tile.bg = TILE_FLAG_UNSEEN;
     m_current_view.fill(default_cell);
     m_next_view.fill(default_cell);
+#ifdef DEBUG_WEBSOCKETS
+    m_map_deflated = 0;
+    m_map_zs = z_stream();
+    deflateInit2(&m_map_zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                 Z_DEFAULT_STRATEGY);
+#endif
 }
 
 TilesFramework::~TilesFramework()
 {
+#ifdef DEBUG_WEBSOCKETS
+    deflateEnd(&m_map_zs);
+#endif
 }
 
+#ifdef DEBUG_WEBSOCKETS
+// The size of msg once deflated as the next message of a stream, the way the
+// webserver's per-message deflate compresses what it sends to clients.
+static size_t _deflated_size(z_stream &zs, const string &msg)
+{
+    unsigned char out[16384];
+    size_t total = 0;
+    zs.next_in = (Bytef *) msg.data();
+    zs.avail_in = msg.size();
+    do
+    {
+        zs.next_out = out;
+        zs.avail_out = sizeof out;
+        deflate(&zs, Z_SYNC_FLUSH);
+        total += sizeof out - zs.avail_out;
+    }
+    while (zs.avail_out == 0);
+    return total;
+}
+#endif
+
 void TilesFramework::shutdown()
 {
     if (m_sock_name.empty())
         return;
 
+#ifdef DEBUG_WEBSOCKETS
+    if (m_map_frames)
+    {
+        fprintf(stderr, "Webtiles map: %u frames, %" PRIu64 " bytes, "
+                        "%" PRIu64 " bytes/frame, %" PRIu64 " deflated "
+                        "(%s cells)\n",
+                m_map_frames, m_map_bytes, m_map_bytes / m_map_frames,
+                m_map_deflated / m_map_frames,
+                m_packed_map ? "packed" : "json");
+    }
+#endif
+
     close(m_sock);
     remove(m_sock_name.c_str());
 }
@@ -196,82 +243,240 @@ void TilesFramework::finish_message()
     }
 
     m_msg_buf.append("\n");
+
+    // The message is written once per receiver; normally the only receiver
+    // is the server, which fans it out to the player and all spectators.
+    for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+    {
+        receiver &dest = m_dest_addrs[i];
+        // Receivers that have fallen behind skip everything until they are
+        // resynchronised in flush_messages(), so that any number of missed
+        // frames are coalesced into one full update.
+        if (m_resyncing ? !dest.resyncing : dest.lagging)
+            continue;
+
+        if (!_send_to_receiver(dest))
+        {
+            // the other side is dead
+            m_dest_addrs.erase(m_dest_addrs.begin() + i);
+            i--;
+        }
+    }
+
+    m_msg_buf.clear();
+    m_need_flush = true;
+#ifdef DEBUG_WEBSOCKETS
+    fprintf(stderr, "websocket: Sent %d bytes.\n", initial_buf_size);
+#endif
+}
+
+/**
+ * Send the current message buffer to one receiver, in fragments.
+ *
+ * The primary receiver (the server that owns the game) has to see every
+ * message, so writes to it are retried. Anything else is only watching, and
+ * is never waited for: see _send_to_watcher().
+ *
+ * @return false if the receiver has gone away and should be forgotten.
+ */
+bool TilesFramework::_send_to_receiver(receiver &dest)
+{
+    if (!dest.primary)
+        return _send_to_watcher(dest);
+
     const char* fragment_start = m_msg_buf.data();
     const char* data_end = m_msg_buf.data() + m_msg_buf.size();
-    int fragments = 0;
     while (fragment_start < data_end)
     {
         int fragment_size = data_end - fragment_start;
         if (fragment_size > m_max_msg_size)
             fragment_size = m_max_msg_size;
-        fragments++;
 
-        for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+        int retries = 30;
+        ssize_t sent = 0;
+        while (sent < fragment_size)
         {
-            int retries = 30;
-            ssize_t sent = 0;
-            while (sent < fragment_size)
-            {
-                ssize_t retval = sendto(m_sock, fragment_start + sent,
-                    fragment_size - sent, 0, (sockaddr*) &m_dest_addrs[i],
-                    sizeof(sockaddr_un));
+            ssize_t retval = sendto(m_sock, fragment_start + sent,
+                fragment_size - sent, 0, (sockaddr*) &dest.addr,
+                sizeof(sockaddr_un));
 #ifdef DEBUG_WEBSOCKETS
-                fprintf(stderr,
-                            "    trying to send fragment to client %d...", i);
+            fprintf(stderr,
+                        "    trying to send fragment...");
 #endif
-                if (retval <= 0)
-                {
-                    const char *errmsg = retval == 0 ? "No bytes sent"
-                                                     : strerror(errno);
-                    if (--retries <= 0)
-                        die("Socket write error: %s", errmsg);
+            if (retval <= 0)
+            {
+                const char *errmsg = retval == 0 ? "No bytes sent"
+                                                 : strerror(errno);
+                if (--retries <= 0)
+                    die("Socket write error: %s", errmsg);
 
-                    if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
-                        || errno == EINTR || errno == EAGAIN)
-                    {
-                        // Wait for half a second at first (up to five), then
-                        // try again.
-                        const int sleep_time = retries > 25 ? 2 * 1000
-                                             : retries > 10 ? 500 * 1000
-                                             : 5000 * 1000;
+                if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
+                    || errno == EINTR || errno == EAGAIN)
+                {
+                    // Wait for half a second at first (up to five), then
+                    // try again.
+                    const int sleep_time = retries > 25 ? 2 * 1000
+                                         : retries > 10 ? 500 * 1000
+                                         : 5000 * 1000;
 #ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr, "failed (%s), sleeping for %dms.\n",
-                                                    errmsg, sleep_time / 1000);
+                    fprintf(stderr, "failed (%s), sleeping for %dms.\n",
+                                                errmsg, sleep_time / 1000);
 #endif
-                        usleep(sleep_time);
-                    }
-                    else if (errno == ECONNREFUSED || errno == ENOENT)
-                    {
-                        // the other side is dead
+                    usleep(sleep_time);
+                }
+                else if (errno == ECONNREFUSED || errno == ENOENT)
+                {
 #ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr,
-                            "failed (%s), breaking.\n", errmsg);
+                    fprintf(stderr,
+                        "failed (%s), breaking.\n", errmsg);
 #endif
-                        m_dest_addrs.erase(m_dest_addrs.begin() + i);
-                        i--;
-                        break;
-                    }
-                    else
-                        die("Socket write error: %s", errmsg);
+                    return false;
                 }
                 else
-                {
+                    die("Socket write error: %s", errmsg);
+            }
+            else
+            {
 #ifdef DEBUG_WEBSOCKETS
-                    fprintf(stderr, "fragment size %d sent.\n", fragment_size);
+                fprintf(stderr, "fragment size %d sent.\n", fragment_size);
 #endif
-                    sent += retval;
-                }
+                sent += retval;
             }
         }
 
         fragment_start += fragment_size;
     }
-    m_msg_buf.clear();
-    m_need_flush = true;
+    return true;
+}
+
+/**
+ * Send fragments of a message to a watcher for as long as it takes them
+ * without blocking.
+ *
+ * @return how far it got, or nullptr if the watcher has gone away.
+ */
+const char *TilesFramework::_send_without_blocking(const receiver &dest,
+                                                   const char *start,
+                                                   const char *end)
+{
+    while (start < end)
+    {
+        const int fragment_size = min<ptrdiff_t>(end - start, m_max_msg_size);
+        ssize_t retval = sendto(m_sock, start, fragment_size, MSG_DONTWAIT,
+                                (sockaddr*) &dest.addr, sizeof(sockaddr_un));
+        if (retval < 0)
+        {
+            if (errno == ECONNREFUSED || errno == ENOENT)
+                return nullptr;
+            if (errno != EWOULDBLOCK && errno != EAGAIN && errno != ENOBUFS
+                && errno != EINTR)
+            {
+                die("Socket write error: %s", strerror(errno));
+            }
+        }
+        if (retval <= 0)
+        {
 #ifdef DEBUG_WEBSOCKETS
-    fprintf(stderr, "websocket: Sent %d bytes in %d fragments.\n",
-                                                initial_buf_size, fragments);
+            fprintf(stderr, "websocket: watcher busy, %d bytes unsent.\n",
+                    (int) (end - start));
 #endif
+            break;
+        }
+        start += retval;
+    }
+    return start;
+}
+
+/**
+ * Send as much as possible of the message a watcher was left part way
+ * through.
+ *
+ * @return false if the watcher has gone away.
+ */
+bool TilesFramework::_send_pending(receiver &dest)
+{
+    if (dest.pending.empty())
+        return true;
+
+    const char *start = dest.pending.data();
+    const char *sent = _send_without_blocking(dest, start,
+                                              start + dest.pending.size());
+    if (!sent)
+        return false;
+    dest.pending.erase(0, sent - start);
+    return true;
+}
+
+/**
+ * Send the current message buffer to a watcher without ever blocking.
+ *
+ * A watcher that can't take the start of the message has it dropped, and
+ * is marked as lagging. One that takes only some of its fragments keeps
+ * the rest to finish first, and is marked lagging too. Either way it skips
+ * later messages until it has caught up and been resynchronised, so it
+ * never sees a partial message.
+ *
+ * @return false if the watcher has gone away and should be forgotten.
+ */
+bool TilesFramework::_send_to_watcher(receiver &dest)
+{
+    if (!_send_pending(dest))
+        return false;
+    if (!dest.pending.empty())
+    {
+        dest.lagging = true;
+        return true;
+    }
+
+    const char *start = m_msg_buf.data();
+    const char *end = start + m_msg_buf.size();
+    const char *sent = _send_without_blocking(dest, start, end);
+    if (!sent)
+        return false;
+    if (sent < end)
+    {
+        if (sent > start)
+            dest.pending.assign(sent, end);
+        dest.lagging = true;
+    }
+    return true;
+}
+
+/**
+ * Bring receivers that dropped messages back up to date by sending them the
+ * whole current state, the same way a newly joined spectator is sent it.
+ * Receivers that are still too busy, or still finishing an earlier message,
+ * stay lagging and are retried at the next flush.
+ */
+void TilesFramework::_resync_lagging_receivers()
+{
+    bool any_lagging = false;
+    for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+    {
+        receiver &dest = m_dest_addrs[i];
+        if (dest.lagging && !_send_pending(dest))
+        {
+            // the other side is dead
+            m_dest_addrs.erase(m_dest_addrs.begin() + i);
+            i--;
+            continue;
+        }
+        dest.resyncing = dest.lagging && dest.pending.empty();
+        if (dest.resyncing)
+            dest.lagging = false;
+        any_lagging = any_lagging || dest.resyncing;
+    }
+    if (!any_lagging)
+        return;
+
+    {
+        unwind_bool resync(m_resyncing, true);
+        _send_everything();
+        send_message("*{\"msg\":\"flush_messages\"}");
+    }
+
+    for (receiver &dest : m_dest_addrs)
+        dest.resyncing = false;
 }
 
 void TilesFramework::send_message(const char *format, ...)
@@ -307,6 +512,8 @@ void TilesFramework::flush_messages()
         send_message("*{\"msg\":\"flush_messages\"}");
         m_need_flush = false;
     }
+
+    _resync_lagging_receivers();
 }
 
 void TilesFramework::_await_connection()
@@ -367,7 +574,12 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
         JsonWrapper primary = json_find_member(obj.node, "primary");
         primary.check(JSON_BOOL);
 
-        m_dest_addrs.push_back(addr);
+        receiver dest;
+        dest.addr = addr;
+        dest.primary = primary->bool_;
+        dest.lagging = false;
+        dest.resyncing = false;
+        m_dest_addrs.push_back(dest);
         m_controlled_from_web = primary->bool_;
     }
     else if (msgtype == "key")
@@ -460,6 +672,25 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
     }
     else if (msgtype == "ui_state_sync")
         ui::recv_ui_state_change(obj.node);
+    else if (msgtype == "map_encoding")
+    {
+        JsonWrapper packed = json_find_member(obj.node, "packed");
+        packed.check(JSON_BOOL);
+        // Every receiver gets the same stream, so only the primary one (the
+        // server passing on the player's own client) may choose it. Start
+        // the client's map afresh in the new encoding.
+        const bool from_primary = any_of(m_dest_addrs.begin(),
+                                         m_dest_addrs.end(),
+            [&addr](const receiver &r)
+            {
+                return r.primary && !strcmp(r.addr.sun_path, addr.sun_path);
+            });
+        if (from_primary && packed->bool_ != m_packed_map)
+        {
+            m_packed_map = packed->bool_;
+            m_need_full_map = true;
+        }
+    }
 
     return c;
 }
@@ -1309,14 +1540,42 @@ void TilesFramework::write_tileidx(tileidx_t t)
         tiles.write_message("[%d,%d]", lo, hi);
 }
 
+// Cell fields in the packed map encoding; keep in sync with
+// unpack_cells() in map_knowledge.js.
+enum packed_cell_field
+{
+    PCF_POS         = 1 << 0,
+    PCF_FEAT        = 1 << 1,
+    PCF_MAP_FEATURE = 1 << 2,
+    PCF_GLYPH       = 1 << 3,
+    PCF_COLOUR      = 1 << 4,
+    PCF_FG          = 1 << 5,
+    PCF_BASE        = 1 << 6,
+    PCF_BG          = 1 << 7,
+    PCF_CLOUD       = 1 << 8,
+};
+
+static int _cell_colour(const screen_cell_t &sc)
+{
+    return (_get_brand(sc.colour) << 4) | macro_colour(sc.colour & 0xF);
+}
+
 void TilesFramework::_send_cell(const coord_def &gc,
                                 const screen_cell_t &current_sc, const screen_cell_t &next_sc,
                                 const map_cell &current_mc, const map_cell &next_mc,
                                 map<uint32_t, coord_def>& new_monster_locs,
                                 bool force_full)
 {
+    // Fields to send in the packed encoding instead of as JSON.
+    unsigned int packed = 0;
+
     if (current_mc.feat() != next_mc.feat())
-        json_write_int("f", next_mc.feat());
+    {
+        if (m_packed_map)
+            packed |= PCF_FEAT;
+        else
+            json_write_int("f", next_mc.feat());
+    }
 
     if (next_mc.monsterinfo())
         _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
@@ -1325,22 +1584,33 @@ void TilesFramework::_send_cell(const coord_def &gc,
 
     map_feature mf = get_cell_map_feature(gc);
     if (get_cell_map_feature(current_mc) != mf)
-        json_write_int("mf", mf);
+    {
+        if (m_packed_map)
+            packed |= PCF_MAP_FEATURE;
+        else
+            json_write_int("mf", mf);
+    }
 
     // Glyph and colour
     char32_t glyph = next_sc.glyph;
     if (current_sc.glyph != glyph)
     {
-        char buf[5];
-        buf[wctoutf8(buf, glyph)] = 0;
-        json_write_string("g", buf);
+        if (m_packed_map)
+            packed |= PCF_GLYPH;
+        else
+        {
+            char buf[5];
+            buf[wctoutf8(buf, glyph)] = 0;
+            json_write_string("g", buf);
+        }
     }
     if ((current_sc.colour != next_sc.colour
          || current_sc.glyph == ' ') && glyph != ' ')
     {
-        int col = next_sc.colour;
-        col = (_get_brand(col) << 4) | macro_colour(col & 0xF);
-        json_write_int("col", col);
+        if (m_packed_map)
+            packed |= PCF_COLOUR;
+        else
+            json_write_int("col", _cell_colour(next_sc));
     }
 
     json_open_object("t");
@@ -1358,22 +1628,40 @@ void TilesFramework::_send_cell(const coord_def &gc,
         {
             fg_changed = true;
 
-            json_write_name("fg");
-            write_tileidx(next_pc.fg);
-            if (get_tile_texture(fg_idx) == TEX_DEFAULT)
-                json_write_int("base", (int) tileidx_known_base_item(fg_idx));
+            if (m_packed_map)
+                packed |= PCF_FG;
+            else
+            {
+                json_write_name("fg");
+                write_tileidx(next_pc.fg);
+                if (get_tile_texture(fg_idx) == TEX_DEFAULT)
+                {
+                    json_write_int("base",
+                                   (int) tileidx_known_base_item(fg_idx));
+                }
+            }
         }
 
         if (next_pc.bg != current_pc.bg)
         {
-            json_write_name("bg");
-            write_tileidx(next_pc.bg);
+            if (m_packed_map)
+                packed |= PCF_BG;
+            else
+            {
+                json_write_name("bg");
+                write_tileidx(next_pc.bg);
+            }
         }
 
         if (next_pc.cloud != current_pc.cloud)
         {
-            json_write_name("cloud");
-            write_tileidx(next_pc.cloud);
+            if (m_packed_map)
+                packed |= PCF_CLOUD;
+            else
+            {
+                json_write_name("cloud");
+                write_tileidx(next_pc.cloud);
+            }
         }
 
         if (next_pc.is_bloody != current_pc.is_bloody)
@@ -1534,6 +1822,109 @@ void TilesFramework::_send_cell(const coord_def &gc,
         }
     }
     json_close_object(true);
+
+    if (packed)
+        _pack_cell(gc, packed, next_sc, next_mc);
+}
+
+static void _pack_uint(string &buf, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buf += (char) ((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buf += (char) value;
+}
+
+// Zigzag encoding, so that small negative numbers stay small.
+static void _pack_int(string &buf, int value)
+{
+    _pack_uint(buf, value < 0 ? ((uint64_t) -(int64_t) value << 1) - 1
+                              : (uint64_t) value << 1);
+}
+
+/**
+ * Append a cell's most frequently changing fields to the packed cell
+ * buffer: the feature, map feature, glyph, colour and the fg, bg and cloud
+ * tiles. Everything else about the cell is still sent as JSON.
+ *
+ * Each cell starts with a varint bitmask of packed_cell_field, followed by
+ * the cell position if PCF_POS is set (otherwise it is the cell after the
+ * last one packed), and then the fields in bit order, as varints. Tiles are
+ * sent as two varints for the low and high 32 bits. The JS client decodes
+ * this in map_knowledge.js.
+ */
+void TilesFramework::_pack_cell(const coord_def &gc, unsigned int fields,
+                                const screen_cell_t &next_sc,
+                                const map_cell &next_mc)
+{
+    if (m_packed_send_gc
+        || m_packed_last_gc.x + 1 != gc.x
+        || m_packed_last_gc.y != gc.y)
+    {
+        fields |= PCF_POS;
+    }
+    const tileidx_t fg_idx = next_sc.tile.fg & TILE_FLAG_MASK;
+    if ((fields & PCF_FG) && get_tile_texture(fg_idx) == TEX_DEFAULT)
+        fields |= PCF_BASE;
+
+    _pack_uint(m_packed_cells, fields);
+    if (fields & PCF_POS)
+    {
+        _pack_int(m_packed_cells, gc.x - m_origin.x);
+        _pack_int(m_packed_cells, gc.y - m_origin.y);
+    }
+    if (fields & PCF_FEAT)
+        _pack_uint(m_packed_cells, next_mc.feat());
+    if (fields & PCF_MAP_FEATURE)
+        _pack_uint(m_packed_cells, get_cell_map_feature(gc));
+    if (fields & PCF_GLYPH)
+        _pack_uint(m_packed_cells, next_sc.glyph);
+    if (fields & PCF_COLOUR)
+        _pack_uint(m_packed_cells, _cell_colour(next_sc));
+    if (fields & PCF_FG)
+    {
+        _pack_uint(m_packed_cells, next_sc.tile.fg & 0xFFFFFFFF);
+        _pack_uint(m_packed_cells, next_sc.tile.fg >> 32);
+    }
+    if (fields & PCF_BASE)
+        _pack_uint(m_packed_cells, tileidx_known_base_item(fg_idx));
+    if (fields & PCF_BG)
+    {
+        _pack_uint(m_packed_cells, next_sc.tile.bg & 0xFFFFFFFF);
+        _pack_uint(m_packed_cells, next_sc.tile.bg >> 32);
+    }
+    if (fields & PCF_CLOUD)
+    {
+        _pack_uint(m_packed_cells, next_sc.tile.cloud & 0xFFFFFFFF);
+        _pack_uint(m_packed_cells, next_sc.tile.cloud >> 32);
+    }
+
+    m_packed_send_gc = false;
+    m_packed_last_gc = gc;
+}
+
+static string _base64_encode(const string &data)
+{
+    static const char *digits =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        const unsigned int n = data.size() - i;
+        uint32_t chunk = (uint8_t) data[i] << 16;
+        if (n > 1)
+            chunk |= (uint8_t) data[i + 1] << 8;
+        if (n > 2)
+            chunk |= (uint8_t) data[i + 2];
+        out += digits[(chunk >> 18) & 0x3F];
+        out += digits[(chunk >> 12) & 0x3F];
+        out += n > 1 ? digits[(chunk >> 6) & 0x3F] : '=';
+        out += n > 2 ? digits[chunk & 0x3F] : '=';
+    }
+    return out;
 }
 
 void TilesFramework::_send_cursor(cursor_type type)
@@ -1617,6 +2008,8 @@ void TilesFramework::_send_map(bool force_full)
 
     coord_def last_gc(0, 0);
     bool send_gc = true;
+    m_packed_cells.clear();
+    m_packed_send_gc = true;
 
     json_open_array("cells");
     for (int y = 0; y < GYM; y++)
@@ -1669,8 +2062,19 @@ void TilesFramework::_send_map(bool force_full)
         }
     json_close_array(true);
 
+    if (!m_packed_cells.empty())
+        json_write_string("packed", _base64_encode(m_packed_cells));
+
     json_close_object(true);
 
+    if (!m_msg_buf.empty())
+    {
+        m_map_frames++;
+        m_map_bytes += m_msg_buf.size();
+#ifdef DEBUG_WEBSOCKETS
+        m_map_deflated += _deflated_size(m_map_zs, m_msg_buf);
+#endif
+    }
     finish_message();
 
     if (force_full)
@@ -1805,11 +2209,21 @@ void TilesFramework::load_dungeon(const crawl_view_buffer &vbuf,
 
             screen_cell_t *cell = &m_next_view(grid);
 
+            // Only cells that change need to be looked at by _send_map();
+            // the others are still what was last sent. Map knowledge can
+            // change without changing the screen cell (monster names and
+            // threat, map flags), so that counts too. map_cell compares
+            // its monster, item and cloud by pointer, so cells holding one
+            // are always resent, and _send_cell() works out what changed.
+            const screen_cell_t old_cell = *cell;
+            const bool was_dirty = is_dirty(grid);
             *cell = ((const screen_cell_t *) vbuf)[x + vbuf.size().x * y];
             pack_cell_overlays(grid, m_next_view);
 
             mark_clean(grid); // Remove redraw flag
-            mark_dirty(grid);
+            if (was_dirty || *cell != old_cell
+                || env.map_knowledge(grid) != m_current_map_knowledge(grid))
+                mark_dirty(grid);
         }
 
     m_next_gc = gc;
@@ -10,6 +10,9 @@
 #include <bitset>
 #include <map>
 #include <sys/un.h>
+#ifdef DEBUG_WEBSOCKETS
+# include <zlib.h>
+#endif
 
 #include "cursor-type.h"
 #include "equipment-type.h"
@@ -214,13 +217,29 @@ protected:
     int m_sock;
     int m_max_msg_size;
     string m_msg_buf;
-    vector<sockaddr_un> m_dest_addrs;
+
+    struct receiver
+    {
+        sockaddr_un addr;
+        bool primary;   // the server running the game; never dropped
+        bool lagging;   // has missed messages and needs a full update
+        bool resyncing; // is being sent that full update
+        string pending; // the unsent end of a message it was part way through
+    };
+    vector<receiver> m_dest_addrs;
 
     bool m_controlled_from_web;
     bool m_need_flush;
 
     bool _send_lock; // not thread safe
-
+    bool m_resyncing;
+
+    bool _send_to_receiver(receiver &dest);
+    bool _send_to_watcher(receiver &dest);
+    bool _send_pending(receiver &dest);
+    const char *_send_without_blocking(const receiver &dest,
+                                       const char *start, const char *end);
+    void _resync_lagging_receivers();
     void _await_connection();
     wint_t _handle_control_message(sockaddr_un addr, string data);
     wint_t _receive_control_message();
@@ -281,6 +300,21 @@ protected:
     map<uint32_t, coord_def> m_monster_locs;
     bool m_need_full_map;
 
+    // Packed map cell encoding, requested by the client; see _pack_cell().
+    bool m_packed_map;
+    string m_packed_cells;
+    coord_def m_packed_last_gc;
+    bool m_packed_send_gc;
+    // Size of the map messages sent, for measuring the encodings.
+    unsigned int m_map_frames;
+    uint64_t m_map_bytes;
+#ifdef DEBUG_WEBSOCKETS
+    // ... and after the webserver's deflate, which keeps its window across
+    // messages.
+    z_stream m_map_zs;
+    uint64_t m_map_deflated;
+#endif
+
     coord_def m_cursor[CURSOR_MAX];
     coord_def m_last_clicked_grid;
     bool m_text_cursor;
@@ -316,6 +350,8 @@ protected:
                     const map_cell &current_mc, const map_cell &next_mc,
                     map<uint32_t, coord_def>& new_monster_locs,
                     bool force_full);
+    void _pack_cell(const coord_def &gc, unsigned int fields,
+                    const screen_cell_t &next_sc, const map_cell &next_mc);
     void _send_monster(const coord_def &gc, const monster_info* m,
                        map<uint32_t, coord_def>& new_monster_locs,
                        bool force_full);
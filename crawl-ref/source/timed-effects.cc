@@ -7,6 +7,8 @@
 
 #include "timed-effects.h"
 
+#include <chrono>
+
 #include "abyss.h"
 #include "act-iter.h"
 #include "areas.h"
@@ -851,18 +853,31 @@ void update_level(int elapsedTime)
     dungeon_events.fire_event(
         dgn_event(DET_TURN_ELAPSED, coord_def(0, 0), turns * 10));
 
+#ifdef DEBUG_DIAGNOSTICS
+    const auto catchup_start = chrono::high_resolution_clock::now();
+#endif
+
+    // Each monster catches up with its own stream, so that how one of them
+    // spent the time doesn't depend on how many rolls the others took, and
+    // the main generator moves on by the same amount however many monsters
+    // there are.
+    const uint64_t catchup_seed = rng::get_uint64();
     for (monster_iterator mi; mi; ++mi)
     {
 #ifdef DEBUG_DIAGNOSTICS
         mons_total++;
 #endif
 
+        rng::subgenerator mon_rng(catchup_seed, mi->mid);
         if (!update_monster(**mi, turns))
             continue;
     }
 
 #ifdef DEBUG_DIAGNOSTICS
-    dprf("total monsters on level = %d", mons_total);
+    const chrono::duration<double, milli> catchup_ms =
+        chrono::high_resolution_clock::now() - catchup_start;
+    dprf("total monsters on level = %d, caught up in %.2f ms", mons_total,
+         catchup_ms.count());
 #endif
 
     delete_all_clouds();
@@ -516,6 +516,109 @@ static bool _is_safe_move(const coord_def& c)
     return _is_safe_cloud(c);
 }
 
+// The flood made for the last travel move, kept between moves.
+//
+// Travel floods outwards from the destination until it reaches the player,
+// and moves to the square the player was reached from. After taking that
+// step, a new flood towards the same destination would reach the player
+// from the square it reached the new position from in the old flood, so
+// long as none of the squares the old flood looked at have changed. Each
+// step then only needs to recheck those squares, rather than flood again.
+struct travel_flood_record
+{
+    bool valid;
+    level_id level;
+    coord_def start;
+    bool slime_check;
+    unsigned int transporters;
+
+    // Every square the flood examined, and its travel state at the time.
+    vector<pair<coord_def, uint8_t>> examined;
+
+    // Which square the flood reached each square from. Entries are only
+    // valid if their stamp matches the generation.
+    unsigned int generation;
+    FixedArray<coord_def, GXM, GYM> parent;
+    FixedArray<unsigned int, GXM, GYM> parent_stamp;
+    FixedArray<unsigned int, GXM, GYM> examined_stamp;
+};
+
+static travel_flood_record last_travel_flood;
+
+// Everything about a square that a travel flood looks at.
+static uint8_t _travel_square_state(const coord_def &c)
+{
+    const dungeon_feature_type feat = env.map_knowledge(c).feat();
+    uint8_t state = _feature_traverse_cost(feat);
+    if (_is_travelsafe_square(c))
+        state |= 1 << 2;
+    if (is_excluded(c))
+        state |= 1 << 3;
+    if (feat == DNGN_TRANSPORTER)
+        state |= 1 << 4;
+    if (grd(c) == DNGN_TRANSPORTER_LANDING)
+        state |= 1 << 5;
+    return state;
+}
+
+static unsigned int _transporter_signature()
+{
+    LevelInfo *li = travel_cache.find_level_info(level_id::current());
+    if (!li)
+        return 0;
+
+    unsigned int sig = 0;
+    for (const transporter_info &ti : li->get_transporters())
+    {
+        sig = sig * 31 + ti.position.x * GYM + ti.position.y;
+        sig = sig * 31 + ti.destination.x * GYM + ti.destination.y;
+    }
+    return sig;
+}
+
+// The next travel move from youpos towards dst, if the last travel flood is
+// still good for it; otherwise the origin.
+static coord_def _recorded_travel_move(const coord_def &youpos,
+                                       const coord_def &dst)
+{
+    travel_flood_record &rec = last_travel_flood;
+    if (!rec.valid
+        || rec.start != dst
+        || rec.level != level_id::current()
+        || rec.parent_stamp(youpos) != rec.generation)
+    {
+        return coord_def();
+    }
+
+    unwind_bool slime_wall_check(g_Slime_Wall_Check,
+                                 !actor_slime_wall_immune(&you));
+    if (rec.slime_check != g_Slime_Wall_Check
+        || rec.transporters != _transporter_signature())
+    {
+        rec.valid = false;
+        return coord_def();
+    }
+    unwind_slime_wall_precomputer slime_neighbours(g_Slime_Wall_Check);
+
+    if (!_is_travelsafe_square(dst, false, false, true) && !is_trap(dst))
+    {
+        rec.valid = false;
+        return coord_def();
+    }
+
+    for (const auto &entry : rec.examined)
+    {
+        if (_travel_square_state(entry.first) != entry.second)
+        {
+            rec.valid = false;
+            return coord_def();
+        }
+    }
+
+    const coord_def move = rec.parent(youpos);
+    return _is_safe_move(move) ? move : coord_def();
+}
+
 void travel_init_load_level()
 {
     curr_excludes.clear();
@@ -1081,7 +1184,7 @@ travel_pathfind::travel_pathfind()
       unexplored_place(), greedy_place(), unexplored_dist(0), greedy_dist(0),
       refdist(nullptr), reseed_points(), features(nullptr), unreachables(),
       point_distance(travel_point_distance), points(0), next_iter_points(0),
-      traveled_distance(0), circ_index(0)
+      traveled_distance(0), circ_index(0), try_fallback(false), record(nullptr)
 {
 }
 
@@ -1129,6 +1232,20 @@ void travel_pathfind::set_distance_grid(travel_distance_grid_t grid)
     point_distance = grid;
 }
 
+void travel_pathfind::set_flood_record(travel_flood_record *rec)
+{
+    record = rec;
+}
+
+void travel_pathfind::record_examined(const coord_def &c)
+{
+    if (record->examined_stamp(c) == record->generation)
+        return;
+
+    record->examined_stamp(c) = record->generation;
+    record->examined.emplace_back(c, _travel_square_state(c));
+}
+
 void travel_pathfind::set_feature_vector(vector<coord_def> *feats)
 {
     features = feats;
@@ -1181,6 +1298,9 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
 
     runmode = rmode;
 
+    if (record)
+        record->valid = false;
+
     try_fallback = fallback_explore;
 
     if (runmode == RMODE_CONNECTIVITY)
@@ -1250,6 +1370,22 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
                                  !actor_slime_wall_immune(&you));
     unwind_slime_wall_precomputer slime_neighbours(g_Slime_Wall_Check);
 
+    if (record)
+    {
+        if (++record->generation == 0)
+        {
+            record->parent_stamp.init(0);
+            record->examined_stamp.init(0);
+            record->generation = 1;
+        }
+        record->level = level_id::current();
+        record->start = start;
+        record->slime_check = g_Slime_Wall_Check;
+        record->transporters = _transporter_signature();
+        record->examined.clear();
+        record_examined(start);
+    }
+
     // How many points are we currently considering? We start off with just one
     // point, and spread outwards like a flood-filler.
     points = 1;
@@ -1293,7 +1429,11 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
             if (path_examine_point(circumference[circ_index][i]))
             {
                 if (runmode == RMODE_TRAVEL)
+                {
+                    if (record)
+                        record->valid = !next_travel_move.origin();
                     return travel_move();
+                }
                 else if (runmode == RMODE_CONNECTIVITY
                          || !Options.explore_wall_bias)
                 {
@@ -1454,6 +1594,9 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
     if (!in_bounds(dc) || unreachables.count(dc))
         return false;
 
+    if (record)
+        record_examined(dc);
+
     if (floodout
         && (runmode == RMODE_EXPLORE || runmode == RMODE_EXPLORE_GREEDY))
     {
@@ -1606,6 +1749,12 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
         circumference[!circ_index][next_iter_points++] = dc;
         point_distance[dc.x][dc.y] = traveled_distance;
 
+        if (record)
+        {
+            record->parent(dc) = c;
+            record->parent_stamp(dc) = record->generation;
+        }
+
         // Negative distances here so that show_map can colour
         // the map differently for these squares.
         if (ignore_hostile)
@@ -1746,20 +1895,32 @@ void find_travel_pos(const coord_def& youpos,
                      vector<coord_def>* features)
 {
     const bool need_move = move_x && move_y;
-    travel_pathfind tp;
+    const bool reuse_flood = need_move && !features;
+    run_mode_type rmode = (need_move) ? RMODE_TRAVEL : RMODE_NOT_RUNNING;
 
-    if (need_move)
-        tp.set_src_dst(youpos, you.running.pos);
-    else
-        tp.set_floodseed(youpos);
+    coord_def dest;
+    if (reuse_flood)
+        dest = _recorded_travel_move(youpos, you.running.pos);
 
-    tp.set_feature_vector(features);
+    if (dest.origin())
+    {
+        travel_pathfind tp;
 
-    run_mode_type rmode = (need_move) ? RMODE_TRAVEL : RMODE_NOT_RUNNING;
+        if (need_move)
+            tp.set_src_dst(youpos, you.running.pos);
+        else
+            tp.set_floodseed(youpos);
 
-    coord_def dest = tp.pathfind(rmode, false);
-    if (dest.origin())
-        dest = tp.pathfind(rmode, true);
+        tp.set_feature_vector(features);
+
+        if (reuse_flood)
+            tp.set_flood_record(&last_travel_flood);
+        dest = tp.pathfind(rmode, false);
+        tp.set_flood_record(nullptr);
+
+        if (dest.origin())
+            dest = tp.pathfind(rmode, true);
+    }
     coord_def new_dest = dest;
 
     // We'd either have to travel through a runed door, in which case we'll be
@@ -483,6 +483,8 @@ private:
 // travel pathfinding directly (but is used internally by interlevel travel).
 // * All coordinates are grid coords.
 // * Do not reuse one travel_pathfind for different runmodes.
+struct travel_flood_record;
+
 class travel_pathfind
 {
 public:
@@ -514,6 +516,10 @@ public:
     // Extract features without pathfinding
     void get_features();
 
+    // Record the cells examined and the shortest path tree of the next
+    // pathfind, so that later moves can reuse it.
+    void set_flood_record(travel_flood_record *rec);
+
     const set<coord_def> get_unreachables() const;
 
     // The next square to go to to move towards the travel destination. Return
@@ -546,6 +552,7 @@ protected:
     bool square_slows_movement(const coord_def &c);
     void check_square_greed(const coord_def &c);
     void good_square(const coord_def &c);
+    void record_examined(const coord_def &c);
 
 protected:
     static const int UNFOUND_DIST  = -30000;
@@ -628,6 +635,8 @@ protected:
     // Attempt to path through temporary obstructions (like sealed doors)
     // due to the possibility they are no longer obstructing us
     bool try_fallback;
+
+    travel_flood_record *record;
 };
 
 extern TravelCache travel_cache;
@@ -1317,6 +1317,55 @@ void run_animation(animation_type anim, use_animation_type type, bool cleanup)
 
 static bool _view_is_updating = false;
 
+// Only frames drawn by viewwindow_count_changes() are compared, so that
+// normal redraws don't pay for it.
+static bool _count_changes = false;
+static vector<screen_cell_t> _last_frame;
+static coord_def _last_frame_size;
+static coord_def _last_frame_gc;
+static int _cells_touched = 0;
+
+/**
+ * Count the cells of a new frame that differ from the last one counted, and
+ * remember it for next time. If the view has scrolled or changed size, the
+ * whole frame counts.
+ */
+static void _update_cells_touched(const crawl_view_buffer &vbuf)
+{
+    const screen_cell_t *cell = vbuf;
+    const int ncells = vbuf.size().x * vbuf.size().y;
+    if (vbuf.size() != _last_frame_size
+        || crawl_view.vgrdc != _last_frame_gc)
+    {
+        _cells_touched = ncells;
+    }
+    else
+    {
+        _cells_touched = 0;
+        for (int i = 0; i < ncells; ++i)
+            if (cell[i] != _last_frame[i])
+                _cells_touched++;
+    }
+
+    _last_frame.assign(cell, cell + ncells);
+    _last_frame_size = vbuf.size();
+    _last_frame_gc = crawl_view.vgrdc;
+}
+
+/**
+ * Redraw the view, as viewwindow(), and count how many of its cells changed
+ * since the last frame drawn by this function. For benchmarks.
+ *
+ * @return the number of changed cells, or the whole view if it has moved.
+ */
+int viewwindow_count_changes(bool show_updates)
+{
+    unwind_bool counting(_count_changes, true);
+    _cells_touched = 0;
+    viewwindow(show_updates);
+    return _cells_touched;
+}
+
 crawl_view_buffer view_dungeon(animation *a, bool anim_updates, view_renderer *renderer);
 
 static bool _viewwindow_should_render()
@@ -1416,6 +1465,8 @@ void viewwindow(bool show_updates, bool tiles_only, animation *a, view_renderer
         if (_viewwindow_should_render())
         {
             const auto vbuf = view_dungeon(a, anim_updates, renderer);
+            if (_count_changes)
+                _update_cells_touched(vbuf);
 
             you.last_view_update = you.num_turns;
 #ifndef USE_TILE_LOCAL
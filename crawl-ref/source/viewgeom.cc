@@ -224,6 +224,22 @@ public:
     }
 };
 
+//////////////////////////////////////////////////////////////////////////////
+// screen_cell_t
+
+bool screen_cell_t::operator ==(const screen_cell_t &other) const
+{
+#ifndef USE_TILE_LOCAL
+    if (glyph != other.glyph || colour != other.colour)
+        return false;
+#endif
+#ifdef USE_TILE
+    if (flash_colour != other.flash_colour || tile != other.tile)
+        return false;
+#endif
+    return true;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // crawl_view_buffer
 
@@ -239,6 +255,13 @@ crawl_view_buffer::crawl_view_buffer(const coord_def &sz)
     resize(sz);
 }
 
+crawl_view_buffer::crawl_view_buffer(const crawl_view_buffer &other)
+    : m_size(0, 0)
+    , m_buffer(nullptr)
+{
+    *this = other;
+}
+
 crawl_view_buffer::~crawl_view_buffer()
 {
     delete [] m_buffer;
@@ -14,6 +14,12 @@ struct screen_cell_t
     unsigned short flash_colour;
     packed_cell tile;
 #endif
+
+    bool operator ==(const screen_cell_t &other) const;
+    bool operator !=(const screen_cell_t &other) const
+    {
+        return !(*this == other);
+    }
 };
 
 class crawl_view_buffer
@@ -21,6 +27,7 @@ class crawl_view_buffer
 public:
     crawl_view_buffer();
     crawl_view_buffer(const coord_def &sz);
+    crawl_view_buffer(const crawl_view_buffer &other);
     ~crawl_view_buffer();
 
     coord_def size() const { return m_size; }
@@ -87,6 +87,9 @@ function ($, comm, map_knowledge, view_data, monster_list, minimap,
         if (data.vgrdc)
             minimap.do_view_center_update(data.vgrdc.x, data.vgrdc.y);
 
+        if (data.packed)
+            map_knowledge.merge(map_knowledge.unpack_cells(data.packed));
+
         if (data.cells)
             map_knowledge.merge(data.cells);
 
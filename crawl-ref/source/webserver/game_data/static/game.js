@@ -224,6 +224,9 @@ function ($, comm, client, dungeon_renderer, display, minimap, enums, messages,
     {
         game_version = data;
         document.title = data.text;
+        // Ask for map cells in the packed encoding. Only the player's
+        // messages reach the game, but every client can decode both.
+        comm.send_message("map_encoding", { packed: true });
     }
 
     function glyph_mode_font_init()
@@ -197,6 +197,81 @@ define(["jquery", "./enums", "./util"], function ($, enums, util) {
 
     }
 
+    // Decode the packed cell encoding written by TilesFramework::_pack_cell
+    // into the same cell diff objects that the JSON encoding produces.
+    var PCF_POS = 1 << 0, PCF_FEAT = 1 << 1, PCF_MAP_FEATURE = 1 << 2,
+        PCF_GLYPH = 1 << 3, PCF_COLOUR = 1 << 4, PCF_FG = 1 << 5,
+        PCF_BASE = 1 << 6, PCF_BG = 1 << 7, PCF_CLOUD = 1 << 8;
+
+    function unpack_cells(packed)
+    {
+        var data = atob(packed);
+        var pos = 0;
+
+        function uint()
+        {
+            var value = 0, scale = 1, b;
+            do
+            {
+                b = data.charCodeAt(pos++);
+                value += (b & 0x7F) * scale;
+                scale *= 128;
+            } while (b & 0x80);
+            return value;
+        }
+
+        function sint()
+        {
+            var value = uint();
+            return value % 2 ? -(value + 1) / 2 : value / 2;
+        }
+
+        // Same as TilesFramework::write_tileidx
+        function tileidx()
+        {
+            var lo = uint() | 0, hi = uint() | 0;
+            return hi == 0 ? lo : [lo, hi];
+        }
+
+        var cells = [];
+        var x = 0, y = 0;
+        while (pos < data.length)
+        {
+            var fields = uint();
+            if (fields & PCF_POS)
+            {
+                x = sint();
+                y = sint();
+            }
+            else
+                x++;
+
+            var cell = {x: x, y: y};
+            if (fields & PCF_FEAT)
+                cell.f = uint();
+            if (fields & PCF_MAP_FEATURE)
+                cell.mf = uint();
+            if (fields & PCF_GLYPH)
+                cell.g = String.fromCodePoint(uint());
+            if (fields & PCF_COLOUR)
+                cell.col = uint();
+            if (fields & (PCF_FG | PCF_BG | PCF_CLOUD))
+            {
+                cell.t = {};
+                if (fields & PCF_FG)
+                    cell.t.fg = tileidx();
+                if (fields & PCF_BASE)
+                    cell.t.base = uint();
+                if (fields & PCF_BG)
+                    cell.t.bg = tileidx();
+                if (fields & PCF_CLOUD)
+                    cell.t.cloud = tileidx();
+            }
+            cells.push(cell);
+        }
+        return cells;
+    }
+
     function merge_diff(vals)
     {
         $.each(vals, function (i, val)
@@ -210,6 +285,7 @@ define(["jquery", "./enums", "./util"], function ($, enums, util) {
     return {
         get: get,
         merge: merge_diff,
+        unpack_cells: unpack_cells,
         clear: clear,
         touch: touch,
         visible: visible,